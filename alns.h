@@ -0,0 +1,4691 @@
+#pragma once
+
+// Núcleo do ALNS para o CVRP: estruturas, operadores e laço de busca.
+// Biblioteca somente de cabeçalho (funções inline, sem estado global); a
+// interface para embutir o solver em outro programa é AlnsSolver, no final.
+// Erros de entrada (arquivo ausente, instância inválida) viram exceções.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <iomanip>
+#include <limits>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <array>
+#include <charconv>
+#include <filesystem>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ALNS_HAS_MMAP 1
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ALNS_HAS_AVX2 1
+#endif
+
+// ==========================================
+// ESTRUTURAS DE DADOS
+// ==========================================
+struct Node
+{
+    int id;
+    double x;
+    double y;
+    int demand;
+};
+
+// Tipo de distância da instância (EDGE_WEIGHT_TYPE do TSPLIB). EXPLICIT vem
+// pronta do arquivo; as métricas de coordenadas são políticas (structs com
+// métodos estáticos) e os laços que as calculam são instanciados por métrica,
+// escolhida uma vez por withMetric, sem desvio por distância.
+enum class EdgeWeight : uint8_t
+{
+    Euc2D,
+    Ceil2D,
+    Explicit
+};
+
+// Euclidiana arredondada ao inteiro mais próximo (EUC_2D, padrão TSPLIB)
+struct Euc2DMetric
+{
+    static double round(double d) { return std::floor(d + 0.5); }
+    static long long of(double dx, double dy) { return (long long)round(std::sqrt(dx * dx + dy * dy)); }
+#ifdef ALNS_HAS_AVX2
+    // d >= 0: somar 0,5 e truncar na conversão equivale ao floor
+    __attribute__((target("avx2"))) static __m256d round4(__m256d d) { return _mm256_add_pd(d, _mm256_set1_pd(0.5)); }
+#endif
+};
+
+// Euclidiana arredondada para cima (CEIL_2D)
+struct Ceil2DMetric
+{
+    static double round(double d) { return std::ceil(d); }
+    static long long of(double dx, double dy) { return (long long)round(std::sqrt(dx * dx + dy * dy)); }
+#ifdef ALNS_HAS_AVX2
+    __attribute__((target("avx2"))) static __m256d round4(__m256d d) { return _mm256_ceil_pd(d); }
+#endif
+};
+
+// fn(métrica) com a política de 'w' (somente métricas de coordenadas)
+template <class Fn>
+inline auto withMetric(EdgeWeight w, Fn fn)
+{
+    if (w == EdgeWeight::Ceil2D)
+        return fn(Ceil2DMetric{});
+    return fn(Euc2DMetric{});
+}
+
+// Matriz de distâncias contígua (row-major). Usa int32 sempre que a faixa de
+// coordenadas permite (cobre todas as instâncias TSPLIB/CVRPLIB) e int64 caso
+// contrário. O layout triangular guarda apenas i >= j (metade da memória),
+// ao custo de um cálculo de índice a mais por consulta. O layout OnTheFly não
+// guarda matriz: cada consulta calcula a distância a partir das coordenadas
+// (memória linear em n, para instâncias grandes demais para a matriz).
+class DistMatrix
+{
+public:
+    enum class Layout
+    {
+        Full,
+        Triangular,
+        OnTheFly
+    };
+
+    void allocate(int n, Layout l, bool needsWide)
+    {
+        dim = n;
+        stride = n;
+        layout = l;
+        wide = needsWide;
+        count = (layout == Layout::Full) ? (size_t)n * n : (size_t)n * (n + 1) / 2;
+        d32 = nullptr;
+        d64 = nullptr;
+        if (wide)
+        {
+            auto buf = std::make_shared<std::vector<long long>>(count, 0);
+            d64 = buf->data();
+            storage = buf;
+        }
+        else
+        {
+            auto buf = std::make_shared<std::vector<int32_t>>(count, 0);
+            d32 = buf->data();
+            storage = buf;
+        }
+    }
+
+    // Sem matriz: guarda só as coordenadas (x, y intercalados)
+    void allocateOnTheFly(const std::vector<Node> &nodes, int n, bool needsWide, EdgeWeight m)
+    {
+        dim = n;
+        stride = n;
+        layout = Layout::OnTheFly;
+        wide = needsWide;
+        ceilMetric = m == EdgeWeight::Ceil2D;
+        count = 0;
+        auto buf = std::make_shared<std::vector<double>>(2 * (size_t)n);
+        for (int i = 0; i < n; ++i)
+        {
+            (*buf)[2 * i] = nodes[i].x;
+            (*buf)[2 * i + 1] = nodes[i].y;
+        }
+        xy = buf->data();
+        d32 = nullptr;
+        d64 = nullptr;
+        storage = buf;
+    }
+
+    // Usa uma matriz já pronta em memória externa (ex.: cache mapeado do disco),
+    // somente leitura; 'owner' mantém essa memória viva enquanto houver cópias
+    void adopt(int n, Layout l, bool isWide, const void *data, std::shared_ptr<const void> owner)
+    {
+        dim = n;
+        stride = n;
+        layout = l;
+        wide = isWide;
+        count = (layout == Layout::Full) ? (size_t)n * n : (size_t)n * (n + 1) / 2;
+        d32 = wide ? nullptr : (int32_t *)data;
+        d64 = wide ? (long long *)data : nullptr;
+        storage = std::move(owner);
+    }
+
+    // Cópia privada com espaço para 'capacity' nós (e em int64 se toWide), para
+    // o plano dinâmico acrescentar nós sem reconstruir a matriz. No layout Full
+    // as linhas passam a ter passo 'capacity'; o triangular e as coordenadas do
+    // OnTheFly só crescem no fim.
+    void reserve(int capacity, bool toWide)
+    {
+        capacity = std::max(capacity, dim);
+        if (layout == Layout::OnTheFly)
+        {
+            auto buf = std::make_shared<std::vector<double>>(2 * (size_t)capacity);
+            std::copy(xy, xy + 2 * (size_t)dim, buf->begin());
+            xy = buf->data();
+            storage = buf;
+            stride = capacity;
+            wide = wide || toWide;
+            return;
+        }
+
+        DistMatrix old = *this;
+        allocate(capacity, layout, wide || toWide);
+        dim = old.dim;
+        for (int i = 0; i < dim; ++i)
+            for (int j = 0; j <= (layout == Layout::Full ? dim - 1 : i); ++j)
+                set(i, j, old(i, j));
+    }
+
+    // Nós com id >= dimensão atual ficam acessíveis. Falta de espaço reserva
+    // 25% a mais (a matriz Full cresce com o quadrado): cópia O(n²) a cada
+    // ~n/4 nós, custo amortizado linear por nó
+    void resize(int n)
+    {
+        if (n > stride)
+            reserve(std::max(n, stride + stride / 4 + 16), false);
+        dim = n;
+    }
+
+    // Coordenadas do nó i no modo OnTheFly (após reserve/resize)
+    void setPoint(int i, double x, double y)
+    {
+        xy[2 * i] = x;
+        xy[2 * i + 1] = y;
+    }
+
+    void set(int i, int j, long long v)
+    {
+        size_t k = index(i, j);
+        if (wide)
+            d64[k] = v;
+        else
+            d32[k] = static_cast<int32_t>(v);
+    }
+
+    long long operator()(int i, int j) const
+    {
+        if (layout == Layout::OnTheFly)
+        {
+            double dx = xy[2 * i] - xy[2 * j], dy = xy[2 * i + 1] - xy[2 * j + 1];
+            double d = std::sqrt(dx * dx + dy * dy);
+            return (long long)(ceilMetric ? Ceil2DMetric::round(d) : Euc2DMetric::round(d));
+        }
+        size_t k = index(i, j);
+        return wide ? d64[k] : d32[k];
+    }
+
+    // Linha contígua (somente layout Full com int32), usada pelos laços internos
+    const int32_t *row32(int i) const
+    {
+        return (layout == Layout::Full && !wide) ? d32 + (size_t)i * stride : nullptr;
+    }
+
+    // Início da linha i no armazenamento (Full: n elementos; Triangular: i + 1)
+    int32_t *rowData32(int i) { return d32 + index(i, 0); }
+    long long *rowData64(int i) { return d64 + index(i, 0); }
+
+    const void *data() const { return wide ? (const void *)d64 : (const void *)d32; }
+    size_t bytes() const { return count * (wide ? sizeof(long long) : sizeof(int32_t)); }
+    bool isWide() const { return wide; }
+    Layout getLayout() const { return layout; }
+    int rowStride() const { return stride; }
+    const double *coords() const { return xy; }
+    bool ceilRounding() const { return ceilMetric; }
+
+private:
+    size_t index(int i, int j) const
+    {
+        if (layout == Layout::Full)
+            return (size_t)i * stride + j;
+        if (i < j)
+            std::swap(i, j);
+        return (size_t)i * (i + 1) / 2 + j;
+    }
+
+    int dim = 0;
+    int stride = 0; // Nós reservados: passo das linhas no layout Full
+    Layout layout = Layout::Full;
+    bool wide = false;
+    size_t count = 0;
+    // Cópias da matriz compartilham o mesmo armazenamento (imutável após a carga;
+    // o plano dinâmico escreve só na cópia privada criada por reserve)
+    std::shared_ptr<const void> storage;
+    int32_t *d32 = nullptr;
+    long long *d64 = nullptr;
+    double *xy = nullptr;    // Somente OnTheFly
+    bool ceilMetric = false; // Somente OnTheFly: CEIL_2D em vez de EUC_2D
+};
+
+// ==========================================
+// ACESSO ÀS DISTÂNCIAS
+// ==========================================
+
+// DistMatrix::operator() decide a cada consulta entre layout, largura e
+// métrica. Os laços quentes (operadores e runAlns) são templates sobre um
+// acessor com essas escolhas fixas: withDistAccess escolhe a instanciação uma
+// vez por busca e nenhuma consulta desvia. Um acessor é um valor barato
+// (ponteiros da matriz, construído a cada chamada de operador) com
+// operator()(i, j) e isWide(). Os ponteiros só valem enquanto a matriz não
+// cresce (DynamicPlan::addCustomer); por isso não são guardados.
+
+// Qualquer layout, com o desvio por consulta: padrão fora dos laços quentes
+struct DynamicDist
+{
+    const DistMatrix *m;
+    explicit DynamicDist(const DistMatrix &dm) : m(&dm) {}
+    long long operator()(int i, int j) const { return (*m)(i, j); }
+    bool isWide() const { return m->isWide(); }
+};
+
+template <class T>
+struct FullDist
+{
+    const T *d;
+    size_t stride;
+    explicit FullDist(const DistMatrix &dm) : d((const T *)dm.data()), stride(dm.rowStride()) {}
+    long long operator()(int i, int j) const { return d[(size_t)i * stride + j]; }
+    constexpr bool isWide() const { return !std::is_same_v<T, int32_t>; }
+};
+
+template <class T>
+struct TriangularDist
+{
+    const T *d;
+    explicit TriangularDist(const DistMatrix &dm) : d((const T *)dm.data()) {}
+    long long operator()(int i, int j) const
+    {
+        if (i < j)
+            std::swap(i, j);
+        return d[(size_t)i * (i + 1) / 2 + j];
+    }
+    constexpr bool isWide() const { return !std::is_same_v<T, int32_t>; }
+};
+
+// Sem matriz: calcula a distância com a métrica M
+template <class M>
+struct CoordDist
+{
+    const double *xy;
+    bool wide;
+    explicit CoordDist(const DistMatrix &dm) : xy(dm.coords()), wide(dm.isWide()) {}
+    long long operator()(int i, int j) const { return M::of(xy[2 * i] - xy[2 * j], xy[2 * i + 1] - xy[2 * j + 1]); }
+    bool isWide() const { return wide; }
+};
+
+// fn(acessor) com o acessor do layout, largura e métrica de m
+template <class Fn>
+inline auto withDistAccess(const DistMatrix &m, Fn fn)
+{
+    switch (m.getLayout())
+    {
+    case DistMatrix::Layout::OnTheFly:
+        if (m.ceilRounding())
+            return fn(CoordDist<Ceil2DMetric>(m));
+        return fn(CoordDist<Euc2DMetric>(m));
+    case DistMatrix::Layout::Triangular:
+        if (m.isWide())
+            return fn(TriangularDist<long long>(m));
+        return fn(TriangularDist<int32_t>(m));
+    default:
+        if (m.isWide())
+            return fn(FullDist<long long>(m));
+        return fn(FullDist<int32_t>(m));
+    }
+}
+
+// Grade uniforme sobre os clientes (ids 1..n-1), ~2 por célula, em formato CSR.
+// Usada no modo sem matriz para as buscas de vizinho mais próximo que, com a
+// matriz, eram varreduras O(n). As buscas percorrem anéis de células em torno
+// do ponto e param quando nenhum anel mais externo pode ter cliente mais
+// próximo. Empates de distância arredondada ficam com o menor id, como numa
+// varredura em ordem crescente de id. Pontos acrescentados depois da
+// construção (plano dinâmico) que não cabem de volta na sua célula ficam numa
+// lista à parte, visitada por toda busca, até a próxima reconstrução.
+class SpatialGrid
+{
+public:
+    void build(const std::vector<Node> &nodes, int n)
+    {
+        minX = minY = std::numeric_limits<double>::max();
+        double maxX = -minX, maxY = -minY;
+        for (int i = 0; i < n; ++i)
+        {
+            minX = std::min(minX, nodes[i].x);
+            maxX = std::max(maxX, nodes[i].x);
+            minY = std::min(minY, nodes[i].y);
+            maxY = std::max(maxY, nodes[i].y);
+        }
+        double w = maxX - minX, h = maxY - minY;
+        cell = std::sqrt(std::max(w * h, 1e-12) / std::max(1, (n - 1) / 2));
+        cell = std::max(cell, std::max(w, h) / 4096 + 1e-9); // Limita o número de células
+        cols = (int)(w / cell) + 1;
+        rows = (int)(h / cell) + 1;
+
+        cellOf.assign(n, -1);
+        start.assign((size_t)cols * rows + 1, 0);
+        for (int c = 1; c < n; ++c)
+        {
+            cellOf[c] = cellIndex(nodes[c].x, nodes[c].y);
+            start[cellOf[c] + 1]++;
+        }
+        for (size_t k = 1; k < start.size(); ++k)
+            start[k] += start[k - 1];
+        live.assign(start.begin(), start.end() - 1);
+        items.assign(std::max(0, n - 1), 0);
+        slot.assign(n, -1);
+        for (int c = 1; c < n; ++c)
+        {
+            slot[c] = live[cellOf[c]]++;
+            items[slot[c]] = c;
+        }
+        for (size_t k = 0; k < live.size(); ++k)
+            live[k] -= start[k]; // live[k] = clientes ativos na célula k
+        px.resize(n);
+        py.resize(n);
+        for (int i = 0; i < n; ++i)
+        {
+            px[i] = nodes[i].x;
+            py[i] = nodes[i].y;
+        }
+        extra.clear();
+    }
+
+    bool empty() const { return cols == 0; }
+
+    // Retira c das buscas (O(1) se c está numa célula); usado em cópias locais
+    // da grade e no plano dinâmico
+    void remove(int c)
+    {
+        int k = cellOf[c];
+        if (k < 0)
+        {
+            auto it = std::find(extra.begin(), extra.end(), c);
+            *it = extra.back();
+            extra.pop_back();
+            return;
+        }
+        int last = start[k] + --live[k];
+        int other = items[last];
+        std::swap(items[slot[c]], items[last]);
+        slot[other] = slot[c];
+        slot[c] = last;
+    }
+
+    // Devolve às buscas o cliente c (retirado antes por remove), agora em
+    // (x, y). Se ele continua na mesma célula, volta ao seu lugar em O(1);
+    // ids novos ou que mudaram de célula vão para a lista à parte.
+    void insert(int c, double x, double y)
+    {
+        if (c >= (int)px.size())
+        {
+            px.resize(c + 1);
+            py.resize(c + 1);
+            cellOf.resize(c + 1, -1);
+            slot.resize(c + 1, -1);
+        }
+        px[c] = x;
+        py[c] = y;
+        int k = cellOf[c];
+        if (k >= 0 && k == cellIndex(x, y))
+        {
+            int first = start[k] + live[k]++;
+            int other = items[first];
+            std::swap(items[slot[c]], items[first]);
+            slot[other] = slot[c];
+            slot[c] = first;
+            return;
+        }
+        cellOf[c] = -1;
+        extra.push_back(c);
+    }
+
+    // Tamanho da lista à parte (acima de poucos por cento de n, vale reconstruir)
+    size_t overflow() const { return extra.size(); }
+
+    // Cliente mais próximo de 'from' (exceto ele) com pred(c); -1 se nenhum
+    template <class D, class Pred>
+    int nearest(int from, const D &dist, Pred pred) const
+    {
+        int best = -1;
+        long long bestDist = std::numeric_limits<long long>::max();
+        scanRings(from, [&](int c)
+                  {
+            if (c == from || !pred(c))
+                return;
+            long long d = dist(from, c);
+            if (d < bestDist || (d == bestDist && c < best))
+            {
+                bestDist = d;
+                best = c;
+            } }, [&]()
+                  { return best >= 0 ? (double)bestDist : -1.0; });
+        return best;
+    }
+
+    // Os k clientes mais próximos de 'from' (exceto ele), em ordem (distância, id)
+    template <class D>
+    void kNearest(int from, int k, const D &dist, std::vector<int> &out) const
+    {
+        std::vector<std::pair<long long, int>> heap; // Max-heap dos k melhores
+        scanRings(from, [&](int c)
+                  {
+            if (c == from)
+                return;
+            std::pair<long long, int> e(dist(from, c), c);
+            if ((int)heap.size() < k)
+            {
+                heap.push_back(e);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if (e < heap.front())
+            {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = e;
+                std::push_heap(heap.begin(), heap.end());
+            } }, [&]()
+                  { return (int)heap.size() == k ? (double)heap.front().first : -1.0; });
+        std::sort_heap(heap.begin(), heap.end());
+        out.clear();
+        for (const auto &e : heap)
+            out.push_back(e.second);
+    }
+
+private:
+    int cellIndex(double x, double y) const
+    {
+        int cx = std::min(cols - 1, std::max(0, (int)((x - minX) / cell)));
+        int cy = std::min(rows - 1, std::max(0, (int)((y - minY) / cell)));
+        return cy * cols + cx;
+    }
+
+    // Visita os clientes ativos anel a anel em torno de 'from'. bound() devolve a
+    // pior distância arredondada ainda aceita (-1 = sem limite); um anel r só
+    // tem pontos a mais de (r - 1) * cell, então a busca para quando esse
+    // limite inferior passa de bound + 0.5 (nenhum arredondamento pode empatar).
+    template <class Visit, class Bound>
+    void scanRings(int from, Visit visit, Bound bound) const
+    {
+        for (int c : extra)
+            visit(c);
+        int c0 = cellIndex(px[from], py[from]);
+        int cx = c0 % cols, cy = c0 / cols;
+        int maxR = std::max(std::max(cx, cols - 1 - cx), std::max(cy, rows - 1 - cy));
+        for (int r = 0; r <= maxR; ++r)
+        {
+            double b = bound();
+            if (r > 0 && b >= 0 && (r - 1) * cell > b + 0.5)
+                return;
+            auto visitCell = [&](int x, int y)
+            {
+                int k = y * cols + x;
+                for (int i = start[k]; i < start[k] + live[k]; ++i)
+                    visit(items[i]);
+            };
+            for (int y = std::max(0, cy - r); y <= std::min(rows - 1, cy + r); ++y)
+            {
+                if (y == cy - r || y == cy + r)
+                {
+                    for (int x = std::max(0, cx - r); x <= std::min(cols - 1, cx + r); ++x)
+                        visitCell(x, y);
+                }
+                else
+                {
+                    if (cx - r >= 0)
+                        visitCell(cx - r, y);
+                    if (cx + r < cols)
+                        visitCell(cx + r, y);
+                }
+            }
+        }
+    }
+
+    double minX = 0, minY = 0, cell = 1;
+    int cols = 0, rows = 0;
+    std::vector<int> start, live, items, slot, cellOf; // cellOf = -1: cliente na lista à parte
+    std::vector<double> px, py;
+    std::vector<int> extra;
+};
+
+struct Instance
+{
+    int dimension;
+    int capacity;
+    std::vector<Node> nodes;
+    EdgeWeight metric = EdgeWeight::Euc2D; // EXPLICIT: coordenadas só para exibição (ou zero)
+    DistMatrix dist;
+
+    // Listas granulares: os neighborK clientes mais próximos de cada nó,
+    // em ordem crescente de (distância, id) (vazio = modo exaustivo)
+    int neighborK = 0;
+    std::vector<int> neighbors;
+
+    const int *neighborsOf(int i) const { return neighbors.data() + (size_t)i * neighborK; }
+
+    // Índice espacial dos clientes (somente no modo sem matriz; vazio caso contrário)
+    SpatialGrid grid;
+
+    // Clientes travados (plano dinâmico): os operadores de destruição não os
+    // retiram da rota. Vazio = nenhum travado.
+    std::vector<char> locked;
+    int lockedCount = 0;
+
+    bool isLocked(int c) const { return lockedCount > 0 && locked[c]; }
+};
+
+struct Route
+{
+    std::vector<int> path; // Sequência de clientes
+    int load;
+    long long cost;
+
+    // arcs[p] = comprimento do arco que sai da posição p (arcs[0] parte do
+    // depósito, arcs[path.size()] volta a ele): a inserção em p desfaz esse
+    // arco sem consultar a distância. Mantido por updateRoute e pelas funções delta.
+    std::vector<int32_t> arcs{0};
+};
+
+// Registro de uma alteração elementar, usado para desfazer iterações rejeitadas
+struct UndoEntry
+{
+    bool inserted; // true = inserção, false = remoção
+    int routeIndex;
+    int position;
+    int customer;
+    int prev, next; // Vizinhos de customer na rota no momento da alteração (0 = depósito)
+};
+
+struct Solution
+{
+    std::vector<Route> routes; // Slots estáveis: rotas vazias permanecem e são reutilizadas
+    long long totalCost;
+    std::vector<int> unassigned;
+
+    // Soma das chaves arcKey dos arcos de todas as rotas (mod 2^64)
+    uint64_t arcHash = 0;
+
+    // Índice cliente -> rota/posição (-1 se não roteado) e slots de rota vazios
+    std::vector<int> routeOf;
+    std::vector<int> posOf;
+    std::vector<int> freeRoutes;
+
+    // Journal de desfazer: ativo apenas entre beginJournal e commit/rollback
+    bool journaling = false;
+    std::vector<UndoEntry> journal;
+};
+
+struct InsertionMove
+{
+    int customerNode;
+    int routeIndex;
+    int position;
+    long long costIncrease;
+};
+
+// ==========================================
+// VARIÁVEIS GLOBAIS E UTILITÁRIOS
+// ==========================================
+
+// Índice de rota usado para pedir a abertura de uma nova rota
+const int NEW_ROUTE = -1;
+
+// Custo por cliente não atendido (Big M)
+const long long UNASSIGNED_PENALTY = 10000000;
+
+// Hash Zobrist aditivo do conjunto de arcos: cada arco não orientado {a, b}
+// tem uma chave pseudoaleatória (splitmix64 do par) e o hash da solução é a
+// soma das chaves. A soma, e não o XOR, conta arcos repetidos (os dois arcos
+// 0-c de uma rota com um só cliente). Não depende da ordem nem do sentido das
+// rotas, nem dos slots em que estão. O laço (a, a) de uma rota vazia vale 0.
+inline uint64_t arcKey(int a, int b)
+{
+    if (a == b)
+        return 0;
+    if (a > b)
+        std::swap(a, b);
+    uint64_t z = ((uint64_t)(uint32_t)a << 32 | (uint32_t)b) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Distância entre dois nós pelas coordenadas, na métrica M (padrão: Euclidiana
+// arredondada, TSPLIB e literatura acadêmica)
+template <class M = Euc2DMetric>
+inline long long calculateDistance(const Node &n1, const Node &n2)
+{
+    return M::of(n1.x - n2.x, n1.y - n2.y);
+}
+
+// Recalcula custo e carga de uma rota
+inline void updateRoute(Route &r, const Instance &inst)
+{
+    long long dist = 0;
+    int load = 0;
+
+    if (r.path.empty())
+    {
+        r.cost = 0;
+        r.load = 0;
+        r.arcs.assign(1, 0);
+        return;
+    }
+
+    // Depósito -> Primeiro
+    dist += inst.dist(0, r.path.front());
+
+    // Caminho
+    for (size_t i = 0; i < r.path.size() - 1; ++i)
+    {
+        dist += inst.dist(r.path[i], r.path[i + 1]);
+        load += inst.nodes[r.path[i]].demand;
+    }
+    // Último
+    load += inst.nodes[r.path.back()].demand;
+
+    // Último -> Depósito
+    dist += inst.dist(r.path.back(), 0);
+
+    r.load = load;
+    r.cost = dist;
+
+    r.arcs.resize(r.path.size() + 1);
+    r.arcs[0] = static_cast<int32_t>(inst.dist(0, r.path.front()));
+    for (size_t p = 1; p < r.path.size(); ++p)
+        r.arcs[p] = static_cast<int32_t>(inst.dist(r.path[p - 1], r.path[p]));
+    r.arcs.back() = static_cast<int32_t>(inst.dist(r.path.back(), 0));
+}
+
+// Recalcula solução inteira
+inline void updateSolution(Solution &sol, const Instance &inst)
+{
+    sol.totalCost = 0;
+    sol.arcHash = 0;
+    for (auto &r : sol.routes)
+    {
+        updateRoute(r, inst);
+        sol.totalCost += r.cost;
+        if (!r.path.empty())
+        {
+            sol.arcHash += arcKey(0, r.path.front()) + arcKey(r.path.back(), 0);
+            for (size_t p = 0; p + 1 < r.path.size(); ++p)
+                sol.arcHash += arcKey(r.path[p], r.path[p + 1]);
+        }
+    }
+    // Penalidade M (Big M) para clientes não atendidos
+    if (!sol.unassigned.empty())
+    {
+        sol.totalCost += sol.unassigned.size() * UNASSIGNED_PENALTY;
+    }
+}
+
+// ==========================================
+// AVALIAÇÃO INCREMENTAL (DELTA)
+// ==========================================
+// Toda remoção/inserção passa por estas funções, que mantêm Route::cost,
+// Route::load e Solution::totalCost em O(1), além do índice cliente -> rota/posição
+// (renumerado apenas no trecho deslocado da rota alterada).
+
+// Reconstrói routeOf/posOf e a lista de slots livres a partir das rotas
+inline void rebuildIndex(Solution &sol, const Instance &inst)
+{
+    sol.routeOf.assign(inst.dimension, -1);
+    sol.posOf.assign(inst.dimension, -1);
+    sol.freeRoutes.clear();
+    for (size_t r = 0; r < sol.routes.size(); ++r)
+    {
+        if (sol.routes[r].path.empty())
+            sol.freeRoutes.push_back(r);
+        for (size_t p = 0; p < sol.routes[r].path.size(); ++p)
+        {
+            sol.routeOf[sol.routes[r].path[p]] = r;
+            sol.posOf[sol.routes[r].path[p]] = p;
+        }
+    }
+}
+
+// Vizinhos de um cliente roteado na sua rota (0 = depósito)
+inline int prevOf(const Solution &sol, int c)
+{
+    int p = sol.posOf[c];
+    return p == 0 ? 0 : sol.routes[sol.routeOf[c]].path[p - 1];
+}
+
+inline int nextOf(const Solution &sol, int c)
+{
+    const auto &path = sol.routes[sol.routeOf[c]].path;
+    int p = sol.posOf[c];
+    return p == (int)path.size() - 1 ? 0 : path[p + 1];
+}
+
+// Remove o cliente da posição pos da rota r e o move para sol.unassigned.
+// Rotas que ficam vazias continuam no mesmo slot e entram na lista de livres.
+template <class D = DynamicDist>
+inline void removeCustomer(Solution &sol, int r, int pos, const Instance &inst)
+{
+    const D dist(inst.dist);
+    Route &route = sol.routes[r];
+    int c = route.path[pos];
+    int prev = (pos == 0) ? 0 : route.path[pos - 1];
+    int next = (pos == (int)route.path.size() - 1) ? 0 : route.path[pos + 1];
+    long long delta = dist(prev, c) + dist(c, next) - dist(prev, next);
+
+    route.cost -= delta;
+    route.load -= inst.nodes[c].demand;
+    route.path.erase(route.path.begin() + pos);
+    route.arcs[pos] = static_cast<int32_t>(dist(prev, next));
+    route.arcs.erase(route.arcs.begin() + pos + 1);
+    for (size_t p = pos; p < route.path.size(); ++p)
+        sol.posOf[route.path[p]] = p;
+    sol.routeOf[c] = -1;
+    sol.posOf[c] = -1;
+    sol.totalCost += UNASSIGNED_PENALTY - delta;
+    sol.arcHash += arcKey(prev, next) - arcKey(prev, c) - arcKey(c, next);
+    sol.unassigned.push_back(c);
+
+    if (route.path.empty())
+        sol.freeRoutes.push_back(r);
+    if (sol.journaling)
+        sol.journal.push_back({false, r, pos, c, prev, next});
+}
+
+// Remove um cliente pelo id em O(1) de localização. Retorna false se não roteado.
+template <class D = DynamicDist>
+inline bool removeCustomerById(Solution &sol, int c, const Instance &inst)
+{
+    if (sol.routeOf[c] < 0)
+        return false;
+    removeCustomer<D>(sol, sol.routeOf[c], sol.posOf[c], inst);
+    return true;
+}
+
+// Insere c na posição pos da rota r (r == NEW_ROUTE abre uma rota em um slot
+// livre ou no fim do vetor). Retorna o índice da rota usada.
+// O chamador é responsável por retirar c de sol.unassigned.
+template <class D = DynamicDist>
+inline int insertCustomer(Solution &sol, int r, int pos, int c, const Instance &inst)
+{
+    const D dist(inst.dist);
+    if (r == NEW_ROUTE)
+    {
+        if (sol.freeRoutes.empty())
+        {
+            sol.routes.push_back(Route{{}, 0, 0});
+            sol.freeRoutes.push_back(sol.routes.size() - 1);
+        }
+        r = sol.freeRoutes.back();
+        pos = 0;
+    }
+    Route &route = sol.routes[r];
+    if (route.path.empty())
+    {
+        // O slot usado é, em geral, o último liberado
+        auto it = std::find(sol.freeRoutes.rbegin(), sol.freeRoutes.rend(), r);
+        sol.freeRoutes.erase(std::next(it).base());
+    }
+    int prev = (pos == 0) ? 0 : route.path[pos - 1];
+    int next = (pos == (int)route.path.size()) ? 0 : route.path[pos];
+    if (sol.journaling)
+        sol.journal.push_back({true, r, pos, c, prev, next});
+    long long delta = dist(prev, c) + dist(c, next) - dist(prev, next);
+
+    route.cost += delta;
+    route.load += inst.nodes[c].demand;
+    route.path.insert(route.path.begin() + pos, c);
+    route.arcs[pos] = static_cast<int32_t>(dist(prev, c));
+    route.arcs.insert(route.arcs.begin() + pos + 1, static_cast<int32_t>(dist(c, next)));
+    for (size_t p = pos; p < route.path.size(); ++p)
+        sol.posOf[route.path[p]] = p;
+    sol.routeOf[c] = r;
+    sol.totalCost += delta - UNASSIGNED_PENALTY;
+    sol.arcHash += arcKey(prev, c) + arcKey(c, next) - arcKey(prev, next);
+    return r;
+}
+
+// Journal de desfazer: em vez de copiar a solução a cada iteração, o laço
+// principal registra as alterações do destroy/repair e, se o candidato for
+// rejeitado, as desfaz em ordem inversa (custo proporcional ao que mudou).
+inline void beginJournal(Solution &sol)
+{
+    sol.journal.clear();
+    sol.journaling = true;
+}
+
+inline void commitJournal(Solution &sol)
+{
+    sol.journal.clear();
+    sol.journaling = false;
+}
+
+template <class D = DynamicDist>
+inline void rollbackJournal(Solution &sol, const Instance &inst)
+{
+    sol.journaling = false;
+    for (auto it = sol.journal.rbegin(); it != sol.journal.rend(); ++it)
+    {
+        // Remover o cliente devolve à lista de livres o slot aberto pela inserção
+        // (e reinserir em uma rota vazia o retira de lá), em ordem LIFO
+        if (it->inserted)
+            removeCustomer<D>(sol, it->routeIndex, it->position, inst);
+        else
+            insertCustomer<D>(sol, it->routeIndex, it->position, it->customer, inst);
+    }
+    // Todos os clientes removidos voltaram às rotas
+    sol.unassigned.clear();
+    sol.journal.clear();
+}
+
+// Modo de depuração (-DALNS_DEBUG): confere os valores incrementais contra o recálculo completo
+inline void verifySolution(const Solution &sol, const Instance &inst, const char *where)
+{
+    Solution check = sol;
+    updateSolution(check, inst);
+    bool ok = check.totalCost == sol.totalCost && check.arcHash == sol.arcHash;
+    for (size_t r = 0; r < sol.routes.size(); ++r)
+    {
+        ok = ok && check.routes[r].cost == sol.routes[r].cost && check.routes[r].load == sol.routes[r].load;
+        ok = ok && check.routes[r].arcs == sol.routes[r].arcs;
+        for (size_t p = 0; p < sol.routes[r].path.size(); ++p)
+            ok = ok && sol.routeOf[sol.routes[r].path[p]] == (int)r && sol.posOf[sol.routes[r].path[p]] == (int)p;
+    }
+    if (!ok)
+    {
+        std::cerr << "Delta inconsistente em " << where << ": incremental " << sol.totalCost
+                  << " vs recalculado " << check.totalCost << std::endl;
+        std::abort();
+    }
+}
+
+#ifdef ALNS_DEBUG
+#define ALNS_VERIFY(sol, inst, where) verifySolution(sol, inst, where)
+#else
+#define ALNS_VERIFY(sol, inst, where) ((void)0)
+#endif
+
+// ==========================================
+// LEITURA E EXPORTAÇÃO
+// ==========================================
+
+// Arquivo inteiro em memória, somente leitura: mmap em sistemas POSIX, leitura
+// completa nos demais. Devolve nullptr se o arquivo não abre ou está vazio.
+inline std::shared_ptr<const char> mapFile(const std::string &path, size_t &size)
+{
+    size = 0;
+#ifdef ALNS_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return nullptr;
+    size = (size_t)st.st_size;
+    size_t len = size;
+    return std::shared_ptr<const char>((const char *)p, [len](const char *q)
+                                       { munmap((void *)q, len); });
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open() || in.tellg() <= 0)
+        return nullptr;
+    size = (size_t)in.tellg();
+    char *buf = new char[size];
+    in.seekg(0);
+    in.read(buf, (std::streamsize)size);
+    return std::shared_ptr<const char>(buf, std::default_delete<const char[]>());
+#endif
+}
+
+// Executa fn(i) para i = 0..n-1 distribuído entre as threads da máquina
+// (intercalado, para equilibrar linhas de tamanhos diferentes)
+template <class Fn>
+inline void parallelRows(int n, Fn fn)
+{
+    int threads = (int)std::min<unsigned>(std::max(1u, std::thread::hardware_concurrency()), (unsigned)std::max(1, n / 64));
+    if (threads <= 1)
+    {
+        for (int i = 0; i < n; ++i)
+            fn(i);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+        workers.emplace_back([&, t]()
+                             {
+            for (int i = t; i < n; i += threads)
+                fn(i); });
+    for (auto &w : workers)
+        w.join();
+}
+
+// Leitor de TSPLIB/CVRPLIB sobre o arquivo mapeado: cada linha é examinada por
+// ponteiros e os números convertidos com std::from_chars, sem cópias de string
+class TsplibScanner
+{
+public:
+    TsplibScanner(const char *begin, const char *end) : p(begin), end(end) {}
+
+    // Próxima linha sem espaços iniciais; false no fim do arquivo
+    bool nextLine()
+    {
+        if (p >= end)
+            return false;
+        const char *nl = (const char *)std::memchr(p, '\n', end - p);
+        lineEnd = nl ? nl : end;
+        cur = p;
+        p = nl ? nl + 1 : end;
+        skipBlanks();
+        return true;
+    }
+
+    bool startsWith(const char *key) const
+    {
+        size_t len = std::strlen(key);
+        return (size_t)(lineEnd - cur) >= len && std::memcmp(cur, key, len) == 0;
+    }
+
+    // Valor inteiro de "CHAVE : valor"
+    bool headerValue(int &out)
+    {
+        const char *colon = (const char *)std::memchr(cur, ':', lineEnd - cur);
+        if (!colon)
+            return false;
+        cur = colon + 1;
+        return next(out);
+    }
+
+    // Palavra de "CHAVE : valor" (ex.: EDGE_WEIGHT_TYPE : EUC_2D)
+    std::string headerWord()
+    {
+        const char *colon = (const char *)std::memchr(cur, ':', lineEnd - cur);
+        cur = colon ? colon + 1 : lineEnd;
+        skipBlanks();
+        const char *w = cur;
+        while (cur < lineEnd && *cur != ' ' && *cur != '\t' && *cur != '\r')
+            ++cur;
+        return std::string(w, cur);
+    }
+
+    template <class T>
+    bool next(T &out)
+    {
+        skipBlanks();
+        auto res = std::from_chars(cur, lineEnd, out);
+        if (res.ec != std::errc())
+            return false;
+        cur = res.ptr;
+        return true;
+    }
+
+private:
+    void skipBlanks()
+    {
+        while (cur < lineEnd && (*cur == ' ' || *cur == '\t' || *cur == '\r'))
+            ++cur;
+    }
+
+    const char *p, *end;
+    const char *cur = nullptr, *lineEnd = nullptr;
+};
+
+inline void buildDistanceMatrix(Instance &inst, DistMatrix::Layout layout);
+inline void buildExplicitMatrix(Instance &inst, DistMatrix::Layout layout, const std::string &format,
+                                const std::vector<long long> &weights);
+inline bool loadInstanceCache(const std::string &cachePath, const std::string &sourcePath, DistMatrix::Layout layout,
+                              Instance &inst);
+inline void writeInstanceCache(const std::string &cachePath, const std::string &sourcePath, const Instance &inst);
+
+// Com cachePath não vazio, usa o cache binário se ele for válido para este
+// arquivo e layout; caso contrário lê o .vrp e (re)grava o cache
+inline Instance loadInstance(const std::string &filepath, DistMatrix::Layout layout = DistMatrix::Layout::Full,
+                             const std::string &cachePath = "")
+{
+    Instance inst;
+    bool useCache = !cachePath.empty() && layout != DistMatrix::Layout::OnTheFly; // Sem matriz, nada a guardar
+    if (useCache && loadInstanceCache(cachePath, filepath, layout, inst))
+        return inst;
+
+    size_t size;
+    std::shared_ptr<const char> file = mapFile(filepath, size);
+    if (!file)
+        throw std::runtime_error("Erro ao abrir arquivo: " + filepath);
+
+    TsplibScanner in(file.get(), file.get() + size);
+    bool cs = false, ds = false, ws = false;
+    std::string format = "FULL_MATRIX"; // EDGE_WEIGHT_FORMAT
+    std::vector<long long> weights;     // EDGE_WEIGHT_SECTION, na ordem do arquivo
+
+    while (in.nextLine())
+    {
+        if (in.startsWith("EOF"))
+            break;
+        if (in.startsWith("DIMENSION"))
+        {
+            in.headerValue(inst.dimension);
+            inst.nodes.resize(inst.dimension + 1);
+        }
+        else if (in.startsWith("CAPACITY"))
+        {
+            in.headerValue(inst.capacity);
+        }
+        else if (in.startsWith("EDGE_WEIGHT_TYPE"))
+        {
+            std::string type = in.headerWord();
+            if (type == "EUC_2D")
+                inst.metric = EdgeWeight::Euc2D;
+            else if (type == "CEIL_2D")
+                inst.metric = EdgeWeight::Ceil2D;
+            else if (type == "EXPLICIT")
+                inst.metric = EdgeWeight::Explicit;
+            else
+                throw std::runtime_error("EDGE_WEIGHT_TYPE nao suportado (" + type + ") em " + filepath);
+        }
+        else if (in.startsWith("EDGE_WEIGHT_FORMAT"))
+        {
+            format = in.headerWord();
+        }
+        else if (in.startsWith("NODE_COORD_SECTION") || in.startsWith("DISPLAY_DATA_SECTION"))
+        {
+            cs = true;
+            ds = ws = false;
+        }
+        else if (in.startsWith("DEMAND_SECTION"))
+        {
+            cs = ws = false;
+            ds = true;
+        }
+        else if (in.startsWith("EDGE_WEIGHT_SECTION"))
+        {
+            cs = ds = false;
+            ws = true;
+        }
+        else if (cs)
+        {
+            int id;
+            double x, y;
+            if (in.next(id) && in.next(x) && in.next(y))
+            {
+                int idx = id - 1;
+                if (idx >= 0 && idx < inst.dimension)
+                {
+                    inst.nodes[idx].id = idx;
+                    inst.nodes[idx].x = x;
+                    inst.nodes[idx].y = y;
+                }
+            }
+        }
+        else if (ds)
+        {
+            int id, d;
+            if (in.next(id) && in.next(d))
+            {
+                int idx = id - 1;
+                if (idx >= 0 && idx < inst.dimension)
+                    inst.nodes[idx].demand = d;
+            }
+        }
+        else if (ws)
+        {
+            long long w;
+            while (in.next(w))
+                weights.push_back(w);
+        }
+        else if (in.startsWith("DEPOT_SECTION"))
+        {
+            cs = ds = ws = false;
+        }
+    }
+    if (inst.dimension < 2)
+        throw std::runtime_error("Instancia invalida: DIMENSION ausente em " + filepath);
+
+    if (inst.metric == EdgeWeight::Explicit)
+        buildExplicitMatrix(inst, layout, format, weights);
+    else
+        buildDistanceMatrix(inst, layout);
+    if (useCache)
+        writeInstanceCache(cachePath, filepath, inst);
+    return inst;
+}
+
+// Uma linha da matriz: out[j] = d(i, j) para j < count na métrica M, como
+// calculateDistance<M>. Coordenadas em SoA; a versão AVX2 faz 4 raízes por vez.
+template <class M, class T>
+inline void distanceRowScalar(T *out, const double *xs, const double *ys, double xi, double yi, int from, int count)
+{
+    for (int j = from; j < count; ++j)
+    {
+        double dx = xs[j] - xi, dy = ys[j] - yi;
+        out[j] = static_cast<T>(M::round(std::sqrt(dx * dx + dy * dy)));
+    }
+}
+
+#ifdef ALNS_HAS_AVX2
+template <class M>
+__attribute__((target("avx2"))) inline void distanceRowAvx2(int32_t *out, const double *xs, const double *ys, double xi,
+                                                             double yi, int count)
+{
+    const __m256d vx = _mm256_set1_pd(xi), vy = _mm256_set1_pd(yi);
+    int j = 0;
+    for (; j + 4 <= count; j += 4)
+    {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + j), vx);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + j), vy);
+        __m256d d = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+        _mm_storeu_si128((__m128i *)(out + j), _mm256_cvttpd_epi32(M::round4(d)));
+    }
+    distanceRowScalar<M>(out, xs, ys, xi, yi, j, count);
+}
+#endif
+
+// Pré-calculo da matriz (int32 se a maior distância possível couber com folga
+// para as somas de três termos dos laços de inserção), uma linha por tarefa
+inline void buildDistanceMatrix(Instance &inst, DistMatrix::Layout layout)
+{
+    int n = inst.dimension;
+    std::vector<double> xs(n), ys(n);
+    double minX = std::numeric_limits<double>::max(), maxX = -minX;
+    double minY = minX, maxY = -minX;
+    for (int i = 0; i < n; ++i)
+    {
+        xs[i] = inst.nodes[i].x;
+        ys[i] = inst.nodes[i].y;
+        minX = std::min(minX, xs[i]);
+        maxX = std::max(maxX, xs[i]);
+        minY = std::min(minY, ys[i]);
+        maxY = std::max(maxY, ys[i]);
+    }
+    double maxDist = std::sqrt((maxX - minX) * (maxX - minX) + (maxY - minY) * (maxY - minY));
+    bool needsWide = maxDist + 1 > std::numeric_limits<int32_t>::max() / 4;
+
+    if (layout == DistMatrix::Layout::OnTheFly)
+    {
+        inst.dist.allocateOnTheFly(inst.nodes, n, needsWide, inst.metric);
+        inst.grid.build(inst.nodes, n);
+        return;
+    }
+    inst.dist.allocate(n, layout, needsWide);
+#ifdef ALNS_HAS_AVX2
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    DistMatrix &dist = inst.dist;
+    withMetric(inst.metric, [&](auto metric)
+               {
+        using M = decltype(metric);
+        parallelRows(n, [&](int i)
+                     {
+            int count = (layout == DistMatrix::Layout::Full) ? n : i + 1;
+            if (needsWide)
+            {
+                distanceRowScalar<M>(dist.rowData64(i), xs.data(), ys.data(), xs[i], ys[i], 0, count);
+                return;
+            }
+#ifdef ALNS_HAS_AVX2
+            if (avx2)
+            {
+                distanceRowAvx2<M>(dist.rowData32(i), xs.data(), ys.data(), xs[i], ys[i], count);
+                return;
+            }
+#endif
+            distanceRowScalar<M>(dist.rowData32(i), xs.data(), ys.data(), xs[i], ys[i], 0, count); }); });
+}
+
+// Matriz EXPLICIT a partir de EDGE_WEIGHT_SECTION. Formatos: FULL_MATRIX
+// (usa a metade inferior), LOWER_ROW, LOWER_DIAG_ROW, UPPER_ROW e
+// UPPER_DIAG_ROW. int32 se o maior peso couber com a mesma folga das
+// métricas de coordenadas. Sem coordenadas, não há modo sem matriz.
+inline void buildExplicitMatrix(Instance &inst, DistMatrix::Layout layout, const std::string &format,
+                                const std::vector<long long> &weights)
+{
+    if (layout == DistMatrix::Layout::OnTheFly)
+        throw std::runtime_error("EDGE_WEIGHT_TYPE EXPLICIT exige a matriz (sem --matrix-free)");
+    int n = inst.dimension;
+    bool full = format == "FULL_MATRIX";
+    bool lower = format == "LOWER_ROW" || format == "LOWER_DIAG_ROW";
+    bool diag = format == "LOWER_DIAG_ROW" || format == "UPPER_DIAG_ROW";
+    if (!full && !lower && format != "UPPER_ROW" && format != "UPPER_DIAG_ROW")
+        throw std::runtime_error("EDGE_WEIGHT_FORMAT nao suportado: " + format);
+    size_t expected = full ? (size_t)n * n : (size_t)n * (n - 1) / 2 + (diag ? n : 0);
+    if (weights.size() != expected)
+        throw std::runtime_error("EDGE_WEIGHT_SECTION com " + std::to_string(weights.size()) + " valores; esperados " +
+                                 std::to_string(expected) + " para " + format);
+    long long maxW = 0;
+    for (long long w : weights)
+    {
+        if (w < 0)
+            throw std::runtime_error("EDGE_WEIGHT_SECTION com peso negativo");
+        maxW = std::max(maxW, w);
+    }
+
+    inst.dist.allocate(n, layout, maxW + 1 > std::numeric_limits<int32_t>::max() / 4);
+    bool both = layout == DistMatrix::Layout::Full;
+    auto put = [&](int i, int j, long long w)
+    {
+        inst.dist.set(i, j, w);
+        if (both)
+            inst.dist.set(j, i, w);
+    };
+    size_t k = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        // Colunas da linha i no formato: [from, to)
+        int from = full ? 0 : lower ? 0 : (diag ? i : i + 1);
+        int to = full ? n : lower ? (diag ? i + 1 : i) : n;
+        for (int j = from; j < to; ++j, ++k)
+            if (!full || j <= i)
+                put(i, j, i == j ? 0 : weights[k]);
+    }
+}
+
+// Pré-calcula os k vizinhos mais próximos (somente clientes) de cada nó
+inline void buildNeighborLists(Instance &inst, int k)
+{
+    k = std::min(k, inst.dimension - 2);
+    inst.neighborK = std::max(k, 0);
+    inst.neighbors.assign((size_t)inst.dimension * inst.neighborK, 0);
+    if (inst.neighborK == 0)
+        return;
+
+    if (!inst.grid.empty())
+    {
+        parallelRows(inst.dimension, [&](int i)
+                     {
+            thread_local std::vector<int> near;
+            inst.grid.kNearest(i, inst.neighborK, inst.dist, near);
+            std::copy(near.begin(), near.end(), inst.neighbors.begin() + (size_t)i * inst.neighborK); });
+        return;
+    }
+
+    parallelRows(inst.dimension, [&](int i)
+                 {
+        thread_local std::vector<int> cand;
+        cand.clear();
+        for (int j = 1; j < inst.dimension; ++j)
+            if (j != i)
+                cand.push_back(j);
+        std::partial_sort(cand.begin(), cand.begin() + inst.neighborK, cand.end(), [&](int a, int b)
+                          {
+            long long da = inst.dist(i, a), db = inst.dist(i, b);
+            return da < db || (da == db && a < b); });
+        std::copy(cand.begin(), cand.begin() + inst.neighborK, inst.neighbors.begin() + (size_t)i * inst.neighborK); });
+}
+
+// ==========================================
+// CACHE BINÁRIO DE INSTÂNCIA
+// ==========================================
+// Cabeçalho + nós + matriz, cada bloco alinhado em 64 bytes. A matriz é usada
+// direto do arquivo mapeado (sem cópia). O cache guarda tamanho e data de
+// modificação do .vrp de origem e é descartado se eles mudarem.
+
+constexpr char CACHE_MAGIC[8] = {'A', 'L', 'N', 'S', 'I', 'N', 'S', 'T'};
+constexpr uint32_t CACHE_VERSION = 2;
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t nodeSize; // sizeof(Node), protege contra mudanças de layout
+    int32_t dimension;
+    int32_t capacity;
+    uint8_t triangular;
+    uint8_t wide;
+    uint8_t metric; // EdgeWeight
+    uint8_t pad[5];
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t nodesOffset;
+    uint64_t matrixOffset;
+    uint64_t matrixBytes;
+};
+
+inline uint64_t alignCache(uint64_t v) { return (v + 63) & ~uint64_t(63); }
+
+inline bool sourceStamp(const std::string &sourcePath, uint64_t &size, int64_t &time)
+{
+    std::error_code ec;
+    size = std::filesystem::file_size(sourcePath, ec);
+    if (ec)
+        return false;
+    auto t = std::filesystem::last_write_time(sourcePath, ec);
+    if (ec)
+        return false;
+    time = (int64_t)t.time_since_epoch().count();
+    return true;
+}
+
+inline bool loadInstanceCache(const std::string &cachePath, const std::string &sourcePath, DistMatrix::Layout layout,
+                              Instance &inst)
+{
+    size_t size;
+    std::shared_ptr<const char> file = mapFile(cachePath, size);
+    if (!file || size < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader h;
+    std::memcpy(&h, file.get(), sizeof(h));
+    uint64_t srcSize;
+    int64_t srcTime;
+    if (std::memcmp(h.magic, CACHE_MAGIC, 8) != 0 || h.version != CACHE_VERSION || h.nodeSize != sizeof(Node) ||
+        h.triangular != (layout == DistMatrix::Layout::Triangular) || !sourceStamp(sourcePath, srcSize, srcTime) ||
+        h.sourceSize != srcSize || h.sourceTime != srcTime ||
+        h.nodesOffset + (uint64_t)h.dimension * sizeof(Node) > size || h.matrixOffset + h.matrixBytes > size)
+        return false;
+
+    inst.dimension = h.dimension;
+    inst.capacity = h.capacity;
+    inst.metric = (EdgeWeight)h.metric;
+    inst.nodes.resize(inst.dimension + 1);
+    std::memcpy(inst.nodes.data(), file.get() + h.nodesOffset, (size_t)h.dimension * sizeof(Node));
+    inst.dist.adopt(h.dimension, layout, h.wide != 0, file.get() + h.matrixOffset, file);
+    return inst.dist.bytes() == h.matrixBytes;
+}
+
+inline void writeInstanceCache(const std::string &cachePath, const std::string &sourcePath, const Instance &inst)
+{
+    CacheHeader h = {};
+    std::memcpy(h.magic, CACHE_MAGIC, 8);
+    h.version = CACHE_VERSION;
+    h.nodeSize = sizeof(Node);
+    h.dimension = inst.dimension;
+    h.capacity = inst.capacity;
+    h.triangular = inst.dist.getLayout() == DistMatrix::Layout::Triangular;
+    h.wide = inst.dist.isWide();
+    h.metric = (uint8_t)inst.metric;
+    if (!sourceStamp(sourcePath, h.sourceSize, h.sourceTime))
+        return;
+    h.nodesOffset = alignCache(sizeof(CacheHeader));
+    h.matrixOffset = alignCache(h.nodesOffset + (uint64_t)inst.dimension * sizeof(Node));
+    h.matrixBytes = inst.dist.bytes();
+
+    // Grava num temporário e renomeia, para execuções simultâneas nunca mapearem um cache parcial
+    std::string tmp = cachePath + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            std::cerr << "Aviso: nao foi possivel gravar o cache " << cachePath << std::endl;
+            return;
+        }
+        const char zeros[64] = {};
+        out.write((const char *)&h, sizeof(h));
+        out.write(zeros, (std::streamsize)(h.nodesOffset - sizeof(h)));
+        out.write((const char *)inst.nodes.data(), (std::streamsize)(inst.dimension * sizeof(Node)));
+        out.write(zeros, (std::streamsize)(h.matrixOffset - h.nodesOffset - inst.dimension * sizeof(Node)));
+        out.write((const char *)inst.dist.data(), (std::streamsize)h.matrixBytes);
+        if (!out)
+        {
+            std::cerr << "Aviso: nao foi possivel gravar o cache " << cachePath << std::endl;
+            out.close();
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, cachePath, ec);
+}
+
+// Coordenadas das rotas para o plot_routes.py (que lê solution_data.txt)
+inline void exportSolution(const Solution &sol, const Instance &inst, const std::string &path)
+{
+    std::ofstream out(path);
+    int r = 0;
+    for (const auto &route : sol.routes)
+    {
+        if (route.path.empty())
+            continue; // Slot livre
+        out << r << " " << inst.nodes[0].x << " " << inst.nodes[0].y << "\n";
+        for (int c : route.path)
+        {
+            out << r << " " << inst.nodes[c].x << " " << inst.nodes[c].y << "\n";
+        }
+        out << r << " " << inst.nodes[0].x << " " << inst.nodes[0].y << "\n";
+        ++r;
+    }
+    out << "-1 " << inst.nodes[0].x << " " << inst.nodes[0].y << "\n"; // Marca depósito
+}
+
+// ==========================================
+// SOLUÇÃO INICIAL (Nearest Neighbor / Clarke-Wright)
+// ==========================================
+
+inline Solution initialSolution(const Instance &inst)
+{
+    Solution sol;
+    std::vector<bool> visited(inst.dimension, false);
+    visited[0] = true;
+    int visitedCount = 1;
+
+    // Modo sem matriz: o vizinho mais próximo vem da grade, da qual os visitados
+    // são retirados; a rota fecha sem busca quando nem a menor demanda restante cabe
+    bool useGrid = !inst.grid.empty();
+    SpatialGrid unvisited;
+    std::vector<int> byDemand;
+    size_t minDemandIdx = 0;
+    if (useGrid)
+    {
+        unvisited = inst.grid;
+        for (int i = 1; i < inst.dimension; ++i)
+            byDemand.push_back(i);
+        std::sort(byDemand.begin(), byDemand.end(), [&](int a, int b)
+                  { return inst.nodes[a].demand < inst.nodes[b].demand; });
+    }
+
+    while (visitedCount < inst.dimension)
+    {
+        Route currentRoute;
+        int currentNode = 0;
+        int currentLoad = 0;
+        bool routeFinished = false;
+
+        while (!routeFinished)
+        {
+            int bestNode = -1;
+            long long bestDist = std::numeric_limits<long long>::max();
+
+            if (useGrid)
+            {
+                while (minDemandIdx < byDemand.size() && visited[byDemand[minDemandIdx]])
+                    ++minDemandIdx;
+                if (minDemandIdx < byDemand.size() &&
+                    currentLoad + inst.nodes[byDemand[minDemandIdx]].demand <= inst.capacity)
+                    bestNode = unvisited.nearest(currentNode, inst.dist, [&](int c)
+                                                 { return currentLoad + inst.nodes[c].demand <= inst.capacity; });
+            }
+            else
+            {
+                for (int i = 1; i < inst.dimension; ++i)
+                {
+                    if (!visited[i])
+                    {
+                        if (currentLoad + inst.nodes[i].demand <= inst.capacity)
+                        {
+                            long long d = inst.dist(currentNode, i);
+                            if (d < bestDist)
+                            {
+                                bestDist = d;
+                                bestNode = i;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (bestNode != -1)
+            {
+                currentRoute.path.push_back(bestNode);
+                visited[bestNode] = true;
+                currentLoad += inst.nodes[bestNode].demand;
+                currentNode = bestNode;
+                visitedCount++;
+                if (useGrid)
+                    unvisited.remove(bestNode);
+            }
+            else
+            {
+                routeFinished = true;
+            }
+        }
+
+        updateRoute(currentRoute, inst);
+        sol.routes.push_back(currentRoute);
+    }
+    updateSolution(sol, inst);
+    rebuildIndex(sol, inst);
+    return sol;
+}
+
+// Par de clientes de Clarke-Wright: economia s(i,j) = d(0,i) + d(0,j) - d(i,j)
+struct Saving
+{
+    long long value;
+    int i, j; // i < j
+
+    // Ordem do heap de máximo: maior economia; no empate, menor (i, j) primeiro
+    bool operator<(const Saving &o) const
+    {
+        if (value != o.value)
+            return value < o.value;
+        return i != o.i ? i > o.i : j > o.j;
+    }
+};
+
+// Clarke-Wright (savings): começa com uma rota por cliente e junta pontas de
+// rotas diferentes em ordem decrescente de economia, enquanto a carga couber.
+// As economias são calculadas em paralelo, uma linha por cliente: com listas
+// granulares, só os pares (i, vizinho de i), O(n·K); sem elas, todos os O(n²)
+// pares (memória quadrática). Um heap entrega os pares em ordem e um
+// union-find diz a rota de cada ponta; o resultado não depende das threads.
+inline Solution savingsSolution(const Instance &inst)
+{
+    int n = inst.dimension;
+    int k = inst.neighborK;
+    std::vector<size_t> start(n + 1, 0); // Pares da linha i em [start[i], start[i + 1])
+    for (int i = 1; i < n; ++i)
+        start[i + 1] = start[i] + (k > 0 ? k : n - 1 - i);
+
+    std::vector<Saving> savings(start[n]);
+    parallelRows(n, [&](int i)
+                 {
+        if (i == 0)
+            return;
+        Saving *out = savings.data() + start[i];
+        long long d0i = inst.dist(0, i);
+        auto put = [&](int j)
+        {
+            // j == 0 completa listas maiores que o número de clientes; descartado abaixo
+            long long s = j == 0 ? 0 : d0i + inst.dist(0, j) - inst.dist(i, j);
+            *out++ = Saving{s, std::min(i, j), std::max(i, j)};
+        };
+        if (k > 0)
+        {
+            const int *nb = inst.neighborsOf(i);
+            for (int t = 0; t < k; ++t)
+                put(nb[t]);
+        }
+        else
+            for (int j = i + 1; j < n; ++j)
+                put(j); });
+    // Economias nulas não encurtam nada. Pares vizinhos mútuos aparecem duas
+    // vezes; a segunda ocorrência cai no teste de mesma rota.
+    savings.erase(std::remove_if(savings.begin(), savings.end(), [](const Saving &s)
+                                 { return s.value <= 0; }),
+                  savings.end());
+
+    // link[c]: vizinhos de c na rota (-1 = depósito), preenchidos na ordem;
+    // c é ponta enquanto link[c][1] == -1
+    std::vector<std::array<int, 2>> link(n, {-1, -1});
+    std::vector<int> parent(n), load(n);
+    for (int c = 0; c < n; ++c)
+    {
+        parent[c] = c;
+        load[c] = inst.nodes[c].demand;
+    }
+    auto find = [&](int c)
+    {
+        while (parent[c] != c)
+            c = parent[c] = parent[parent[c]];
+        return c;
+    };
+
+    std::make_heap(savings.begin(), savings.end());
+    for (auto end = savings.end(); end != savings.begin(); --end)
+    {
+        std::pop_heap(savings.begin(), end);
+        int a = (end - 1)->i, b = (end - 1)->j;
+        if (link[a][1] != -1 || link[b][1] != -1)
+            continue; // Algum dos dois já é interno à sua rota
+        int ra = find(a), rb = find(b);
+        if (ra == rb || load[ra] + load[rb] > inst.capacity)
+            continue;
+        link[a][link[a][0] != -1] = b;
+        link[b][link[b][0] != -1] = a;
+        parent[rb] = ra;
+        load[ra] += load[rb];
+    }
+
+    // Cada rota é percorrida a partir de uma de suas pontas
+    Solution sol;
+    std::vector<char> done(n, 0);
+    for (int c = 1; c < n; ++c)
+    {
+        if (done[c] || link[c][1] != -1)
+            continue;
+        Route route;
+        for (int prev = -1, cur = c; cur != -1;)
+        {
+            route.path.push_back(cur);
+            done[cur] = 1;
+            int next = link[cur][0] == prev ? link[cur][1] : link[cur][0];
+            prev = cur;
+            cur = next;
+        }
+        updateRoute(route, inst);
+        sol.routes.push_back(std::move(route));
+    }
+    updateSolution(sol, inst);
+    rebuildIndex(sol, inst);
+    return sol;
+}
+
+// ==========================================
+// OPERADORES DE DESTRUIÇÃO (REMOVAL)
+// ==========================================
+
+// 1. Random Removal
+// Clientes roteados e não travados, candidatos dos operadores quando há travas
+inline void removableCustomers(const Solution &sol, const Instance &inst, std::vector<int> &out)
+{
+    out.clear();
+    for (const auto &r : sol.routes)
+        for (int c : r.path)
+            if (!inst.isLocked(c))
+                out.push_back(c);
+}
+
+template <class D = DynamicDist>
+inline void destroyRandom(Solution &sol, int q, const Instance &inst, std::mt19937 &rng)
+{
+    // Com travas, sorteia sem reposição entre os clientes removíveis
+    if (inst.lockedCount > 0)
+    {
+        std::vector<int> cand;
+        removableCustomers(sol, inst, cand);
+        for (int k = 0; k < q && !cand.empty(); ++k)
+        {
+            int i = std::uniform_int_distribution<>(0, (int)cand.size() - 1)(rng);
+            removeCustomerById<D>(sol, cand[i], inst);
+            cand[i] = cand.back();
+            cand.pop_back();
+        }
+        return;
+    }
+
+    std::uniform_int_distribution<> pickSlot(0, std::max(0, (int)sol.routes.size() - 1));
+    for (int k = 0; k < q; ++k)
+    {
+        if (sol.freeRoutes.size() == sol.routes.size())
+            break;
+
+        // Sorteia uma rota não vazia (rejeição sobre os slots: uniforme entre as não vazias)
+        int rIdx;
+        do
+            rIdx = pickSlot(rng);
+        while (sol.routes[rIdx].path.empty());
+        int nodePos = std::uniform_int_distribution<>(0, (int)sol.routes[rIdx].path.size() - 1)(rng);
+
+        removeCustomer<D>(sol, rIdx, nodePos, inst);
+    }
+}
+
+// 2. Worst Removal (Remove quem gera maior custo marginal)
+
+// Grau de determinismo do Worst: sorteia o cliente de posição floor(y^p * n) na
+// lista ordenada por economia, y ~ U(0,1) (Ropke & Pisinger usam p = 3)
+constexpr double WORST_REMOVAL_P = 3.0;
+
+// Treap de estatística de ordem sobre os clientes (nós indexados pelo id),
+// ordenada por economia de remoção decrescente com desempate pelo id (usada
+// pelo Worst Removal). Sorteia o k-ésimo pior cliente e atualiza a economia de
+// um cliente em O(log n) esperado.
+class RemovalGainTreap
+{
+public:
+    // Esvazia a treap para ids em [0, n); as prioridades só são refeitas se n mudou
+    void reset(int n)
+    {
+        if ((int)nodes.size() != n)
+        {
+            nodes.assign(n, TreapNode());
+            // Prioridades por hash do id: independentes da ordem das chaves e sem consumir o RNG da busca
+            for (int c = 0; c < n; ++c)
+            {
+                uint64_t z = (uint64_t)(c + 1) * 0x9E3779B97F4A7C15ULL;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                nodes[c].prio = (uint32_t)((z ^ (z >> 27)) >> 32);
+            }
+        }
+        for (TreapNode &t : nodes)
+            t.size = 0;
+        root = -1;
+    }
+
+    int capacity() const { return (int)nodes.size(); }
+    bool contains(int c) const { return nodes[c].size > 0; }
+    long long gain(int c) const { return nodes[c].gain; }
+    void setGain(int c, long long g) { nodes[c].gain = g; }
+    bool before(int a, int b) const
+    {
+        return nodes[a].gain > nodes[b].gain || (nodes[a].gain == nodes[b].gain && a < b);
+    }
+
+    // Constrói em O(n) a partir de ids já ordenados por before (pilha da árvore cartesiana)
+    void build(const std::vector<int> &sorted)
+    {
+        thread_local std::vector<int> stack;
+        stack.clear();
+        for (int c : sorted)
+        {
+            int last = -1;
+            while (!stack.empty() && nodes[stack.back()].prio < nodes[c].prio)
+            {
+                last = stack.back();
+                stack.pop_back();
+                pull(last);
+            }
+            nodes[c].left = last;
+            nodes[c].right = -1;
+            if (!stack.empty())
+                nodes[stack.back()].right = c;
+            stack.push_back(c);
+        }
+        while (!stack.empty())
+        {
+            pull(stack.back());
+            root = stack.back();
+            stack.pop_back();
+        }
+    }
+
+    int count() const { return sz(root); }
+
+    void insert(int c, long long g)
+    {
+        nodes[c].gain = g;
+        root = insertAt(root, c);
+    }
+
+    void erase(int c) { root = eraseAt(root, c); }
+
+    // k-ésimo elemento (0 = maior economia)
+    int select(int k) const
+    {
+        int t = root;
+        while (true)
+        {
+            int ls = sz(nodes[t].left);
+            if (k < ls)
+                t = nodes[t].left;
+            else if (k == ls)
+                return t;
+            else
+            {
+                k -= ls + 1;
+                t = nodes[t].right;
+            }
+        }
+    }
+
+private:
+    struct TreapNode
+    {
+        long long gain = 0;
+        int left = -1, right = -1, size = 0;
+        uint32_t prio = 0;
+    };
+
+    int sz(int t) const { return t < 0 ? 0 : nodes[t].size; }
+    void pull(int t) { nodes[t].size = 1 + sz(nodes[t].left) + sz(nodes[t].right); }
+
+    // l = elementos antes de c, r = o restante
+    void split(int t, int c, int &l, int &r)
+    {
+        if (t < 0)
+        {
+            l = r = -1;
+            return;
+        }
+        if (before(t, c))
+        {
+            split(nodes[t].right, c, nodes[t].right, r);
+            l = t;
+        }
+        else
+        {
+            split(nodes[t].left, c, l, nodes[t].left);
+            r = t;
+        }
+        pull(t);
+    }
+
+    int merge(int a, int b)
+    {
+        if (a < 0)
+            return b;
+        if (b < 0)
+            return a;
+        if (nodes[a].prio > nodes[b].prio)
+        {
+            nodes[a].right = merge(nodes[a].right, b);
+            pull(a);
+            return a;
+        }
+        nodes[b].left = merge(a, nodes[b].left);
+        pull(b);
+        return b;
+    }
+
+    // Desce até a profundidade da prioridade de c e só divide a subárvore abaixo dela
+    int insertAt(int t, int c)
+    {
+        if (t < 0 || nodes[c].prio > nodes[t].prio)
+        {
+            split(t, c, nodes[c].left, nodes[c].right);
+            pull(c);
+            return c;
+        }
+        if (before(c, t))
+            nodes[t].left = insertAt(nodes[t].left, c);
+        else
+            nodes[t].right = insertAt(nodes[t].right, c);
+        nodes[t].size++;
+        return t;
+    }
+
+    int eraseAt(int t, int c)
+    {
+        if (t == c)
+        {
+            nodes[c].size = 0; // Fora da treap (contains)
+            return merge(nodes[t].left, nodes[t].right);
+        }
+        if (before(c, t))
+            nodes[t].left = eraseAt(nodes[t].left, c);
+        else
+            nodes[t].right = eraseAt(nodes[t].right, c);
+        nodes[t].size--;
+        return t;
+    }
+
+    std::vector<TreapNode> nodes;
+    int root = -1;
+};
+
+// Economia ao remover c da sua rota: d(prev,c) + d(c,next) - d(prev,next)
+template <class D = DynamicDist>
+inline long long removalGain(const Solution &sol, int c, const Instance &inst)
+{
+    const D dist(inst.dist);
+    int prev = prevOf(sol, c), next = nextOf(sol, c);
+    return dist(prev, c) + dist(c, next) - dist(prev, next);
+}
+
+// Economias de remoção do Worst Removal mantidas entre chamadas, para uma
+// única solução (a corrente de uma busca). Fica fora de Solution, que continua
+// um valor simples de copiar: quem a mantém anota em 'dirty' os clientes cuja
+// economia pode ter mudado, e a treap é corrigida na próxima chamada do
+// operador (refreshRemovalGains). Trocar a solução inteira (migração, lote,
+// rebuildIndex) exige invalidate().
+struct RemovalGainCache
+{
+    RemovalGainTreap treap;
+    std::vector<int> dirty;
+    std::vector<char> isDirty;
+    bool valid = false;
+
+    void invalidate() { valid = false; }
+
+    // c == 0 é o depósito
+    void markDirty(int c)
+    {
+        if (!valid || c == 0)
+            return;
+        if (c >= (int)isDirty.size())
+        {
+            valid = false; // Instância cresceu (plano dinâmico)
+            return;
+        }
+        if (!isDirty[c])
+        {
+            isDirty[c] = 1;
+            dirty.push_back(c);
+        }
+    }
+
+    // Antes de commitJournal/rollbackJournal: o cliente de cada alteração e
+    // seus vizinhos de então cobrem toda economia que mudou na iteração, nos
+    // dois sentidos (o rollback desfaz exatamente essas alterações)
+    void noteJournal(const Solution &sol)
+    {
+        for (const UndoEntry &e : sol.journal)
+        {
+            markDirty(e.prev);
+            markDirty(e.customer);
+            markDirty(e.next);
+        }
+    }
+};
+
+// Deixa cache.treap com a economia de todo cliente roteado e não travado de
+// sol. A primeira chamada (ou após invalidate) monta a treap em O(n log n); as
+// seguintes só conferem os d clientes anotados desde a anterior e reposicionam
+// os que mudaram de economia ou entraram/saíram das rotas, O(d log n). Com mais
+// de n/4 anotados (remoções grandes seguidas de reparo) a remontagem sai mais
+// barata e é usada, sem alocar: os vetores de apoio são reaproveitados.
+template <class D = DynamicDist>
+inline void refreshRemovalGains(RemovalGainCache &cache, const Solution &sol, const Instance &inst)
+{
+    RemovalGainTreap &treap = cache.treap;
+    if (!cache.valid || treap.capacity() != inst.dimension || (int)cache.dirty.size() * 4 > inst.dimension)
+    {
+        treap.reset(inst.dimension);
+        thread_local std::vector<std::pair<long long, int>> byGain; // (-economia, id): ordem crescente = ordem da treap
+        thread_local std::vector<int> order;
+        byGain.clear();
+        for (const auto &r : sol.routes)
+            for (int c : r.path)
+            {
+                if (inst.isLocked(c))
+                    continue;
+                long long g = removalGain<D>(sol, c, inst);
+                treap.setGain(c, g);
+                byGain.push_back({-g, c});
+            }
+        std::sort(byGain.begin(), byGain.end());
+        order.resize(byGain.size());
+        for (size_t i = 0; i < byGain.size(); ++i)
+            order[i] = byGain[i].second;
+        treap.build(order);
+        cache.dirty.clear();
+        cache.isDirty.assign(inst.dimension, 0);
+        cache.valid = true;
+        return;
+    }
+
+    for (int c : cache.dirty)
+    {
+        cache.isDirty[c] = 0;
+        bool wanted = sol.routeOf[c] >= 0 && !inst.isLocked(c);
+        long long g = wanted ? removalGain<D>(sol, c, inst) : 0;
+        if (treap.contains(c))
+        {
+            if (wanted && treap.gain(c) == g)
+                continue;
+            treap.erase(c);
+        }
+        if (wanted)
+            treap.insert(c, g);
+    }
+    cache.dirty.clear();
+
+#ifdef ALNS_DEBUG
+    int expected = 0;
+    for (const auto &r : sol.routes)
+        for (int c : r.path)
+            if (!inst.isLocked(c))
+            {
+                expected++;
+                if (!treap.contains(c) || treap.gain(c) != removalGain<D>(sol, c, inst))
+                {
+                    std::cerr << "Economia de remocao desatualizada para o cliente " << c << std::endl;
+                    std::abort();
+                }
+            }
+    if (expected != treap.count())
+    {
+        std::cerr << "Treap de economias com " << treap.count() << " clientes, esperados " << expected << std::endl;
+        std::abort();
+    }
+#endif
+}
+
+// A cada remoção só o cliente, o antecessor e o sucessor mudam na treap.
+// 'cache' deve acompanhar sol desde a chamada anterior (ver RemovalGainCache);
+// sem ele, uma treap da thread é montada do zero a cada chamada.
+template <class D = DynamicDist>
+inline void destroyWorst(Solution &sol, int q, const Instance &inst, std::mt19937 &rng,
+                         RemovalGainCache *cache = nullptr)
+{
+    thread_local RemovalGainCache scratch;
+    if (!cache)
+    {
+        scratch.invalidate();
+        cache = &scratch;
+    }
+    refreshRemovalGains<D>(*cache, sol, inst);
+    RemovalGainTreap &treap = cache->treap;
+    std::uniform_real_distribution<> unif(0.0, 1.0);
+    for (int k = 0; k < q && treap.count() > 0; ++k)
+    {
+        int rank = std::min(treap.count() - 1, (int)(std::pow(unif(rng), WORST_REMOVAL_P) * treap.count()));
+        int c = treap.select(rank);
+        int prev = prevOf(sol, c), next = nextOf(sol, c);
+        removeCustomer<D>(sol, sol.routeOf[c], sol.posOf[c], inst);
+        cache->markDirty(prev);
+        cache->markDirty(c);
+        cache->markDirty(next);
+        refreshRemovalGains<D>(*cache, sol, inst);
+    }
+}
+
+// 3. Shaw Removal (Relatedness Removal)
+template <class D = DynamicDist>
+inline void destroyShaw(Solution &sol, int q, const Instance &inst, std::mt19937 &rng)
+{
+    const D dist(inst.dist);
+    if (sol.freeRoutes.size() == sol.routes.size())
+        return;
+
+    // Semente aleatória (uniforme entre os clientes roteados e não travados)
+    int seed;
+    if (inst.lockedCount > 0)
+    {
+        std::vector<int> cand;
+        removableCustomers(sol, inst, cand);
+        if (cand.empty())
+            return;
+        seed = cand[std::uniform_int_distribution<>(0, (int)cand.size() - 1)(rng)];
+    }
+    else
+    {
+        std::uniform_int_distribution<> pickCustomer(1, inst.dimension - 1);
+        do
+            seed = pickCustomer(rng);
+        while (sol.routeOf[seed] < 0);
+    }
+    std::vector<int> removed = {seed};
+
+    // Remove semente
+    removeCustomerById<D>(sol, seed, inst);
+
+    // Remove os (q-1) mais relacionados à semente ou aos já removidos
+    while ((int)removed.size() < q)
+    {
+        int rVal = removed[std::uniform_int_distribution<>(0, (int)removed.size() - 1)(rng)];
+
+        int bestCand = -1;
+
+        // Modo granular: o primeiro vizinho ainda roteado é o mais relacionado
+        const int *nb = inst.neighborsOf(rVal);
+        for (int k = 0; k < inst.neighborK; ++k)
+        {
+            if (sol.routeOf[nb[k]] >= 0 && !inst.isLocked(nb[k]))
+            {
+                bestCand = nb[k];
+                break;
+            }
+        }
+
+        // Sem matriz, a grade devolve o cliente roteado mais próximo
+        if (bestCand == -1 && !inst.grid.empty())
+            bestCand = inst.grid.nearest(rVal, dist, [&](int c)
+                                         { return sol.routeOf[c] >= 0 && !inst.isLocked(c); });
+
+        if (bestCand == -1)
+        {
+            long long minRel = std::numeric_limits<long long>::max();
+            for (const auto &r : sol.routes)
+            {
+                for (int c : r.path)
+                {
+                    if (inst.isLocked(c))
+                        continue;
+                    // Relatedness (Similiaridade): Distância; empate fica com o menor id, como na grade
+                    long long rel = dist(rVal, c);
+                    if (rel < minRel || (rel == minRel && c < bestCand))
+                    {
+                        minRel = rel;
+                        bestCand = c;
+                    }
+                }
+            }
+        }
+
+        if (bestCand != -1)
+        {
+            removed.push_back(bestCand);
+            removeCustomerById<D>(sol, bestCand, inst);
+        }
+        else
+            break;
+    }
+}
+
+// ==========================================
+// POOL DE THREADS
+// ==========================================
+
+// Pool fixo com um único primitivo, parallelFor: executa f(i) para i em
+// [0, count) distribuindo os índices entre os workers e a própria thread
+// chamadora, e só retorna quando todos terminaram. Não suporta chamadas aninhadas.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int n)
+    {
+        for (int i = 1; i < n; ++i)
+            workers.emplace_back([this]()
+                                 { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto &w : workers)
+            w.join();
+    }
+
+    int size() const { return (int)workers.size() + 1; }
+
+    void parallelFor(int count, const std::function<void(int)> &f)
+    {
+        if (count <= 0)
+            return;
+        if (workers.empty() || count == 1)
+        {
+            for (int i = 0; i < count; ++i)
+                f(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job = &f;
+            total = count;
+            next = 0;
+            done = 0;
+            ++generation;
+        }
+        cv.notify_all();
+        runTasks();
+        std::unique_lock<std::mutex> lock(mtx);
+        cvDone.wait(lock, [&]()
+                    { return active == 0 && done == total; });
+        job = nullptr;
+    }
+
+private:
+    void runTasks()
+    {
+        int i;
+        while ((i = next.fetch_add(1)) < total)
+        {
+            (*job)(i);
+            done.fetch_add(1);
+        }
+    }
+
+    void workerLoop()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true)
+        {
+            cv.wait(lock, [&]()
+                    { return stop || (job && generation != seen); });
+            if (stop)
+                return;
+            seen = generation;
+            ++active;
+            lock.unlock();
+            runTasks();
+            lock.lock();
+            if (--active == 0)
+                cvDone.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable cv, cvDone;
+    const std::function<void(int)> *job = nullptr;
+    int total = 0;
+    int active = 0;
+    uint64_t generation = 0;
+    bool stop = false;
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+};
+
+// fn(i) para i em [0, count): no pool, em blocos contíguos (vários por thread,
+// para equilibrar a carga), ou em série sem pool
+template <typename Fn>
+inline void parallelChunks(ThreadPool *pool, int count, const Fn &fn)
+{
+    if (!pool || pool->size() == 1)
+    {
+        for (int i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+    int chunks = std::min(count, pool->size() * 4);
+    int step = (count + chunks - 1) / std::max(chunks, 1);
+    pool->parallelFor(chunks, [&](int c)
+                      {
+        for (int i = c * step; i < std::min(count, (c + 1) * step); ++i)
+            fn(i); });
+}
+
+// ==========================================
+// OPERADORES DE REPARO (INSERTION)
+// ==========================================
+
+// Reparo paralelo (AlnsParams::repairThreads): abaixo desse número de clientes
+// pendentes o custo de despachar para o pool supera o ganho
+constexpr int PARALLEL_REPAIR_MIN = 256;
+
+// Rejeição antecipada (AlnsParams::earlyRejection): com distâncias euclidianas
+// arredondadas, d(p,c) + d(c,n) - d(p,n) >= -1 (>= 0 em CEIL_2D), então cada
+// inserção restante custa ao menos -1 e o custo final não fica abaixo de
+// parcial - restantes. Matrizes EXPLICIT não garantem a desigualdade
+// triangular: nelas o limiar é sorteado igual, mas o reparo não é interrompido.
+constexpr long long MIN_INSERTION_DELTA = -1;
+
+// true se, com 'remaining' clientes ainda fora das rotas, o reparo não pode
+// terminar com custo abaixo de rejectAt
+inline bool cannotBeat(const Solution &sol, size_t remaining, long long rejectAt)
+{
+    long long partial = sol.totalCost - (long long)remaining * UNASSIGNED_PENALTY;
+    return partial + (long long)remaining * MIN_INSERTION_DELTA >= rejectAt;
+}
+
+// Auxiliar: Encontra melhor posição para UM cliente
+template <class D = DynamicDist>
+inline InsertionMove findBestPosition(int cust, int rIdx, const Solution &sol, const Instance &inst)
+{
+    const D dist(inst.dist);
+    InsertionMove bestMove = {cust, rIdx, -1, std::numeric_limits<long long>::max()};
+    const Route &r = sol.routes[rIdx];
+
+    // Slots vazios não são rotas: a opção "nova rota" é tratada à parte
+    if (r.path.empty() || r.load + inst.nodes[cust].demand > inst.capacity)
+        return bestMove;
+
+    // Uma distância nova por posição (d(cust, next) vira o d(cust, prev) da
+    // seguinte); o arco desfeito vem de r.arcs, exato quando as distâncias cabem em int32
+    bool arcsExact = !dist.isWide();
+    long long left = dist(cust, 0);
+    int prev = 0;
+    for (size_t p = 0; p <= r.path.size(); ++p)
+    {
+        int next = (p == r.path.size()) ? 0 : r.path[p];
+        long long right = dist(cust, next);
+        long long costInc = left + right - (arcsExact ? r.arcs[p] : dist(prev, next));
+        left = right;
+        prev = next;
+
+        if (costInc < bestMove.costIncrease)
+        {
+            bestMove.costIncrease = costInc;
+            bestMove.position = p;
+        }
+    }
+    return bestMove;
+}
+
+// Auxiliar: avalia em m as posições antes e depois do vizinho v (na rota de v)
+template <class D = DynamicDist>
+inline void offerNeighborPositions(int cust, int v, const Solution &sol, const Instance &inst, InsertionMove &m)
+{
+    const D dist(inst.dist);
+    const Route &r = sol.routes[sol.routeOf[v]];
+    int vPos = sol.posOf[v];
+    for (int p = vPos; p <= vPos + 1; ++p)
+    {
+        int prev = (p == 0) ? 0 : r.path[p - 1];
+        int next = (p == (int)r.path.size()) ? 0 : r.path[p];
+        long long costInc = (dist(prev, cust) + dist(cust, next)) - dist(prev, next);
+        if (costInc < m.costIncrease)
+        {
+            m.costIncrease = costInc;
+            m.position = p;
+        }
+    }
+}
+
+// Auxiliar: Melhor inserção por rota, avaliando apenas as posições adjacentes
+// aos vizinhos granulares de cust. Rotas sem vizinhos não geram movimento.
+template <class D = DynamicDist>
+inline void collectGranularMoves(int cust, const Solution &sol, const Instance &inst, std::vector<InsertionMove> &moves)
+{
+    moves.clear();
+    const int *nb = inst.neighborsOf(cust);
+    for (int k = 0; k < inst.neighborK; ++k)
+    {
+        int v = nb[k];
+        int rIdx = sol.routeOf[v];
+        if (rIdx < 0)
+            continue;
+        const Route &r = sol.routes[rIdx];
+        if (r.load + inst.nodes[cust].demand > inst.capacity)
+            continue;
+
+        InsertionMove *m = nullptr;
+        for (auto &mv : moves)
+            if (mv.routeIndex == rIdx)
+                m = &mv;
+        if (!m)
+        {
+            moves.push_back({cust, rIdx, -1, std::numeric_limits<long long>::max()});
+            m = &moves.back();
+        }
+        offerNeighborPositions<D>(cust, v, sol, inst, *m);
+    }
+}
+
+// Auxiliar: o movimento de collectGranularMoves para uma única rota
+// (position == -1 se a rota não tem vizinho de cust ou não comporta a demanda)
+template <class D = DynamicDist>
+inline InsertionMove granularMoveInRoute(int cust, int rIdx, const Solution &sol, const Instance &inst)
+{
+    const D dist(inst.dist);
+    InsertionMove m = {cust, rIdx, -1, std::numeric_limits<long long>::max()};
+    const Route &r = sol.routes[rIdx];
+    if (r.path.empty() || r.load + inst.nodes[cust].demand > inst.capacity)
+        return m;
+    const int *nb = inst.neighborsOf(cust);
+    if ((int)r.path.size() >= inst.neighborK)
+    {
+        for (int k = 0; k < inst.neighborK; ++k)
+            if (sol.routeOf[nb[k]] == rIdx)
+                offerNeighborPositions<D>(cust, nb[k], sol, inst, m);
+        return m;
+    }
+
+    // Rota curta: uma passada pelas posições, como findBestPosition, avaliando só
+    // as que tocam um vizinho (v é vizinho se vem antes do último da lista em
+    // (distância, id))
+    int last = nb[inst.neighborK - 1];
+    long long lastDist = dist(cust, last);
+    bool arcsExact = !dist.isWide();
+    long long left = dist(cust, 0);
+    int prev = 0;
+    bool prevIsNeighbor = false;
+    for (size_t p = 0; p <= r.path.size(); ++p)
+    {
+        int next = (p == r.path.size()) ? 0 : r.path[p];
+        long long right = dist(cust, next);
+        bool nextIsNeighbor = next != 0 && (right < lastDist || (right == lastDist && next <= last));
+        if (prevIsNeighbor || nextIsNeighbor)
+        {
+            long long costInc = left + right - (arcsExact ? r.arcs[p] : dist(prev, next));
+            if (costInc < m.costIncrease)
+            {
+                m.costIncrease = costInc;
+                m.position = p;
+            }
+        }
+        left = right;
+        prev = next;
+        prevIsNeighbor = nextIsNeighbor;
+    }
+    return m;
+}
+
+// 1. Greedy Insertion
+// Os reparos param (deixando os restantes em sol.unassigned) assim que o
+// custo final não pode ficar abaixo de rejectAt
+template <class D = DynamicDist>
+inline void repairGreedy(Solution &sol, const Instance &inst, std::mt19937 &rng,
+                         long long rejectAt = std::numeric_limits<long long>::max())
+{
+    const D dist(inst.dist);
+    // Embaralha para evitar viés de ordem
+    std::shuffle(sol.unassigned.begin(), sol.unassigned.end(), rng);
+
+    bool granular = inst.neighborK > 0;
+    std::vector<InsertionMove> moves;
+
+    while (!sol.unassigned.empty())
+    {
+        if (cannotBeat(sol, sol.unassigned.size(), rejectAt))
+            return;
+        int cust = sol.unassigned.back();
+        sol.unassigned.pop_back();
+
+        InsertionMove globalBest = {cust, -1, -1, std::numeric_limits<long long>::max()};
+
+        // Modo granular: só posições vizinhas aos clientes mais próximos
+        if (granular)
+        {
+            collectGranularMoves<D>(cust, sol, inst, moves);
+            for (const auto &m : moves)
+                if (m.costIncrease < globalBest.costIncrease)
+                    globalBest = m;
+        }
+
+        // Tenta em todas as rotas existentes (modo exaustivo ou sem vizinho viável)
+        if (globalBest.routeIndex == -1)
+        {
+            for (size_t r = 0; r < sol.routes.size(); ++r)
+            {
+                InsertionMove m = findBestPosition<D>(cust, r, sol, inst);
+                if (m.position != -1 && m.costIncrease < globalBest.costIncrease)
+                    globalBest = m;
+            }
+        }
+
+        // Tenta criar nova rota
+        long long newRouteCost = dist(0, cust) + dist(cust, 0);
+        if (newRouteCost < globalBest.costIncrease)
+        {
+            globalBest = {cust, NEW_ROUTE, 0, newRouteCost};
+        }
+
+        // Aplica inserção
+        insertCustomer<D>(sol, globalBest.routeIndex, globalBest.position, cust, inst);
+    }
+}
+
+// 2. k-Regret Insertion
+// Guarda, por cliente pendente, só as k + REGRET_SPARE inserções mais baratas
+// (uma por rota, em ordem crescente), de modo que a memória cresce com q·k e não
+// com q·rotas. Após cada inserção só a rota modificada é reavaliada. Se ela piora
+// e sai da lista, as rotas de fora (todas no mínimo tão caras quanto o último
+// guardado) continuam desconhecidas; as rotas do cliente só são varridas de novo
+// quando sobram menos de k entradas. No modo granular as opções de um cliente
+// são as de collectGranularMoves, como no Greedy; só quem não tem vizinho em
+// rota viável cai na varredura de todas as rotas. Com pool, o preenchimento inicial e a
+// reavaliação após cada inserção (independentes por cliente) são divididos
+// entre as threads; a escolha por regret continua uma inserção por vez, então
+// o resultado é o mesmo da versão serial.
+constexpr int REGRET_SPARE = 4;
+
+template <class D = DynamicDist>
+inline void repairRegret(Solution &sol, const Instance &inst, int k = 2, ThreadPool *pool = nullptr,
+                         long long rejectAt = std::numeric_limits<long long>::max())
+{
+    const D dist(inst.dist);
+    k = std::max(2, std::min(k, 15));
+    const int cap = k + REGRET_SPARE;
+    if (cannotBeat(sol, sol.unassigned.size(), rejectAt))
+        return;
+    std::vector<int> pending = sol.unassigned;
+    sol.unassigned.clear();
+
+    std::vector<std::vector<InsertionMove>> top(pending.size()); // [cliente] melhores rotas
+    std::vector<char> truncated(pending.size(), 0);              // alguma rota viável ficou de fora
+    std::vector<char> fullScan(pending.size(), 0);               // opções vindas de todas as rotas
+    const bool granular = inst.neighborK > 0;
+
+    // Custo de inserir o cliente i na rota r, na mesma vizinhança que gerou sua lista
+    auto evaluate = [&](size_t i, int r)
+    {
+        return fullScan[i] ? findBestPosition<D>(pending[i], r, sol, inst)
+                           : granularMoveInRoute<D>(pending[i], r, sol, inst);
+    };
+
+    // Insere m mantendo a ordem (empates depois dos já presentes) e o limite cap
+    auto insertTop = [&](size_t i, const InsertionMove &m)
+    {
+        auto &t = top[i];
+        auto it = t.begin();
+        while (it != t.end() && it->costIncrease <= m.costIncrease)
+            ++it;
+        t.insert(it, m);
+        if ((int)t.size() > cap)
+        {
+            t.pop_back();
+            truncated[i] = 1;
+        }
+    };
+
+    auto offerTop = [&](size_t i, const InsertionMove &m)
+    {
+        if ((int)top[i].size() < cap || m.costIncrease < top[i].back().costIncrease)
+            insertTop(i, m);
+        else
+            truncated[i] = 1;
+    };
+
+    thread_local std::vector<InsertionMove> moves;
+    auto rescanTop = [&](size_t i)
+    {
+        top[i].clear();
+        truncated[i] = 0;
+        fullScan[i] = 0;
+        if (granular)
+        {
+            collectGranularMoves<D>(pending[i], sol, inst, moves);
+            for (const auto &m : moves)
+                offerTop(i, m);
+            if (!top[i].empty())
+                return;
+        }
+        fullScan[i] = 1;
+        for (size_t r = 0; r < sol.routes.size(); ++r)
+        {
+            InsertionMove m = findBestPosition<D>(pending[i], r, sol, inst);
+            if (m.position != -1)
+                offerTop(i, m);
+        }
+    };
+
+    // Para cada cliente não alocado: k melhores opções = top-k das rotas + nova rota
+    std::vector<long long> regretOf(pending.size());
+    auto scoreRegret = [&](size_t i)
+    {
+        int cust = pending[i];
+        long long newRouteCost = dist(0, cust) + dist(cust, 0);
+
+        long long options[16];
+        int m = 0;
+        bool newUsed = false;
+        for (const auto &mv : top[i])
+        {
+            long long c = mv.costIncrease;
+            if (!newUsed && newRouteCost < c)
+            {
+                options[m++] = newRouteCost;
+                newUsed = true;
+                if (m == k)
+                    break;
+            }
+            options[m++] = c;
+            if (m == k)
+                break;
+        }
+        if (!newUsed && m < k)
+            options[m++] = newRouteCost;
+
+        // Regret-k = soma das diferenças entre as k melhores opções e a melhor
+        long long regret = 0;
+        if (m >= 2)
+            for (int j = 1; j < m; ++j)
+                regret += options[j] - options[0];
+        else
+            regret = options[0]; // Prioridade máxima se só tem uma opção
+        regretOf[i] = regret;
+    };
+
+    // Cada cliente pendente só toca sua própria lista
+    auto forEachPending = [&](const auto &fn)
+    {
+        if ((int)pending.size() >= PARALLEL_REPAIR_MIN)
+            parallelChunks(pool, (int)pending.size(), fn);
+        else
+            for (size_t i = 0; i < pending.size(); ++i)
+                fn(i);
+    };
+
+    // Rota fora da lista de i: ou não comportava i (e continua não comportando),
+    // ou todas as suas posições custavam ao menos o último guardado. Só as duas
+    // posições criadas ao lado de c (a-c e c-b) podem ser novidade; no modo
+    // granular elas contam se a, c ou b for vizinho de i.
+    auto newPositionsMove = [&](size_t i, int r, int c)
+    {
+        int cust = pending[i];
+        const Route &route = sol.routes[r];
+        InsertionMove m = {cust, r, -1, std::numeric_limits<long long>::max()};
+        if (route.load + inst.nodes[cust].demand > inst.capacity)
+            return m;
+        int p = sol.posOf[c];
+        int a = (p == 0) ? 0 : route.path[p - 1];
+        int b = (p + 1 == (int)route.path.size()) ? 0 : route.path[p + 1];
+        long long toC = dist(cust, c);
+        bool nbA = true, nbC = true, nbB = true;
+        if (!fullScan[i])
+        {
+            int last = inst.neighborsOf(cust)[inst.neighborK - 1];
+            long long lastDist = dist(cust, last);
+            auto isNeighbor = [&](int v, long long d)
+            { return v != 0 && (d < lastDist || (d == lastDist && v <= last)); };
+            nbA = isNeighbor(a, dist(cust, a));
+            nbC = isNeighbor(c, toC);
+            nbB = isNeighbor(b, dist(cust, b));
+        }
+        if (nbA || nbC)
+            m = {cust, r, p, dist(a, cust) + toC - dist(a, c)};
+        if (nbC || nbB)
+        {
+            long long costInc = toC + dist(cust, b) - dist(c, b);
+            if (costInc < m.costIncrease)
+                m = {cust, r, p + 1, costInc};
+        }
+        return m;
+    };
+
+    // Reavalia a rota r, que acabou de receber c (ou foi aberta para ele), para todos os pendentes
+    auto refreshRoute = [&](int r, int c)
+    {
+        forEachPending([&](size_t i)
+                       {
+            auto &t = top[i];
+            // Limite inferior do custo das rotas fora da lista
+            long long bound = t.empty() ? 0 : t.back().costIncrease;
+            auto pos = std::find_if(t.begin(), t.end(), [&](const InsertionMove &e)
+                                    { return e.routeIndex == r; });
+            InsertionMove m;
+            if (pos != t.end())
+            {
+                t.erase(pos);
+                m = evaluate(i, r);
+            }
+            else
+                m = newPositionsMove(i, r, c);
+
+            if (m.position != -1)
+            {
+                if (!truncated[i] || m.costIncrease <= bound)
+                    insertTop(i, m);
+                else
+                    truncated[i] = 1;
+            }
+            // Granular sem opção viável: rescanTop cai na varredura completa
+            if ((truncated[i] && (int)t.size() < k) || (t.empty() && !fullScan[i]))
+                rescanTop(i);
+            scoreRegret(i); });
+    };
+
+    // Preenchimento inicial
+    forEachPending([&](size_t i)
+                   {
+        rescanTop(i);
+        scoreRegret(i); });
+
+    while (!pending.empty())
+    {
+        if (cannotBeat(sol, pending.size(), rejectAt))
+        {
+            sol.unassigned = pending;
+            return;
+        }
+
+        // Maior regret (o primeiro, em caso de empate)
+        size_t bestCandIdx = std::max_element(regretOf.begin(), regretOf.end()) - regretOf.begin();
+        int cust = pending[bestCandIdx];
+        long long newRouteCost = dist(0, cust) + dist(cust, 0);
+        InsertionMove bestMove = {cust, NEW_ROUTE, 0, newRouteCost};
+        if (!top[bestCandIdx].empty() && top[bestCandIdx][0].costIncrease <= newRouteCost)
+            bestMove = top[bestCandIdx][0];
+
+        // Insere o cliente com maior regret na sua melhor posição
+        std::swap(pending[bestCandIdx], pending.back());
+        std::swap(top[bestCandIdx], top.back());
+        std::swap(truncated[bestCandIdx], truncated.back());
+        std::swap(fullScan[bestCandIdx], fullScan.back());
+        std::swap(regretOf[bestCandIdx], regretOf.back());
+        pending.pop_back();
+        top.pop_back();
+        truncated.pop_back();
+        fullScan.pop_back();
+        regretOf.pop_back();
+
+        refreshRoute(insertCustomer<D>(sol, bestMove.routeIndex, bestMove.position, cust, inst), cust);
+    }
+}
+
+// ==========================================
+// SELETOR DE OPERADORES (ROULETTE WHEEL)
+// ==========================================
+
+inline int selectOperator(const std::vector<double> &weights, std::mt19937 &rng)
+{
+    double total = 0;
+    for (double w : weights)
+        total += w;
+    std::uniform_real_distribution<> dis(0, total);
+    double val = dis(rng);
+    double acc = 0;
+    for (size_t i = 0; i < weights.size(); ++i)
+    {
+        acc += weights[i];
+        if (val <= acc)
+            return i;
+    }
+    return weights.size() - 1;
+}
+
+// ==========================================
+// PARÂMETROS E LAÇO DO ALNS
+// ==========================================
+
+// Situação da busca entregue a AlnsParams::onProgress
+struct AlnsProgress
+{
+    int island;          // 0 na busca simples
+    long long iteration; // Iteração da ilha
+    double seconds;      // Desde o início da busca
+    long long currentCost;
+    long long bestCost; // Melhor da ilha
+    double temperature;
+    bool newBest; // Chamada motivada por um novo melhor
+};
+
+struct AlnsParams
+{
+    // Para ALNS puro funcionar bem, precisamos de MUITAS iterações, pois ele
+    // não tem busca local para limpar a "sujeira" deixada pela inserção gulosa.
+    int maxIter = 50000;         // Aumentado para explorar bem (50k)
+    double maxTimeSeconds = 120; // Tempo para garantir que não fique rodando eternamente
+
+    // SA Parameters
+    double startTempFactor = 0.05; // T0 = 5% do custo inicial
+    // T0 partindo de uma solução já boa (--init, --construct cw): alto demais, o SA a abandona
+    // nas primeiras centenas de iterações
+    double warmStartTempFactor = 0.001;
+    double coolingRate = 0.9997; // Resfriamento lento para permitir exploração
+
+    // ALNS Parameters
+    double minRemPct = 0.10; // Remover min 10%
+    double maxRemPct = 0.40; // Remover max 40% (Range amplo para sair de ótimo local)
+
+    // Pesos adaptativos
+    double sigma1 = 33; // Novo Global
+    double sigma2 = 9;  // Novo Melhor que Atual
+    double sigma3 = 13; // Pior Aceito
+    double reactionFactor = 0.1;
+    int segmentSize = 100;
+
+    // Modelo de ilhas: buscas independentes, uma por thread, trocando soluções
+    int threads = 1;
+    int migrationInterval = 500; // Iterações entre migrações
+
+    // Lote paralelo: K candidatos (destroy/repair independentes) por iteração
+    int batchSize = 1;
+
+    // Threads do reparo de um candidato (somente sem lote; com ilhas, por ilha)
+    int repairThreads = 1;
+
+    // Sorteia o limiar do SA antes do reparo, que para assim que o candidato
+    // não pode mais ser aceito. Mesma distribuição de aceitação, mas outra
+    // sequência do RNG (a mesma semente dá outra busca que sem a opção).
+    bool earlyRejection = false;
+
+    // Tamanho da tabela de soluções recentes (hash de arcos). Um candidato
+    // completo já visto é rejeitado sem pontuação nem teste do SA. 0 desliga.
+    // A tabela não entra no checkpoint: retomar recomeça com ela vazia.
+    int recentSolutions = 0;
+
+    // Decomposição (instâncias grandes): > 0 divide a solução em grupos de
+    // rotas com cerca de decompositionSize clientes, otimizados em paralelo
+    // (threads = grupos simultâneos, sem ilhas) por decompositionIterations
+    // iterações por rodada. maxIter passa a ser o total de iterações de cada
+    // região ao longo das rodadas. Sem checkpoint.
+    int decompositionSize = 0;
+    int decompositionIterations = 2000;
+
+    bool verbose = true; // Imprime "Novo Best" e o aviso de tempo limite
+
+    // Checkpoint do estado da busca (somente busca simples, sem ilhas)
+    std::string checkpointPath;
+    int checkpointInterval = 1000; // Iterações entre gravações (e uma ao final)
+
+    // Uso como biblioteca. onProgress é chamado a cada novo melhor e, com
+    // progressInterval > 0, a cada progressInterval iterações; com ilhas, as
+    // chamadas são serializadas. A busca para quando *cancel vira true ou
+    // quando *cancelEpoch deixa de ser cancelEpochAtStart: quem cancela
+    // incrementa a época, e pedidos anteriores ao início da busca não contam.
+    std::function<void(const AlnsProgress &)> onProgress;
+    int progressInterval = 0;
+    const std::atomic<bool> *cancel = nullptr;
+    const std::atomic<uint64_t> *cancelEpoch = nullptr;
+    uint64_t cancelEpochAtStart = 0;
+};
+
+inline bool cancelRequested(const AlnsParams &prm)
+{
+    return (prm.cancel && prm.cancel->load(std::memory_order_relaxed)) ||
+           (prm.cancelEpoch && prm.cancelEpoch->load(std::memory_order_relaxed) != prm.cancelEpochAtStart);
+}
+
+// ==========================================
+// PARÂMETROS POR NOME (ARQUIVO / LINHA DE COMANDO)
+// ==========================================
+// Os campos numéricos de AlnsParams com o mesmo nome do código. Arquivo de
+// configuração: uma atribuição "nome = valor" por linha, '#' inicia comentário.
+
+struct ParamField
+{
+    const char *name;
+    double AlnsParams::*real; // Exatamente um dos dois é não nulo
+    int AlnsParams::*integer;
+};
+
+inline const std::vector<ParamField> &paramFields()
+{
+    static const std::vector<ParamField> fields = {
+        {"maxIter", nullptr, &AlnsParams::maxIter},
+        {"maxTimeSeconds", &AlnsParams::maxTimeSeconds, nullptr},
+        {"startTempFactor", &AlnsParams::startTempFactor, nullptr},
+        {"warmStartTempFactor", &AlnsParams::warmStartTempFactor, nullptr},
+        {"coolingRate", &AlnsParams::coolingRate, nullptr},
+        {"minRemPct", &AlnsParams::minRemPct, nullptr},
+        {"maxRemPct", &AlnsParams::maxRemPct, nullptr},
+        {"sigma1", &AlnsParams::sigma1, nullptr},
+        {"sigma2", &AlnsParams::sigma2, nullptr},
+        {"sigma3", &AlnsParams::sigma3, nullptr},
+        {"reactionFactor", &AlnsParams::reactionFactor, nullptr},
+        {"segmentSize", nullptr, &AlnsParams::segmentSize},
+        {"threads", nullptr, &AlnsParams::threads},
+        {"migrationInterval", nullptr, &AlnsParams::migrationInterval},
+        {"batchSize", nullptr, &AlnsParams::batchSize},
+        {"repairThreads", nullptr, &AlnsParams::repairThreads},
+        {"recentSolutions", nullptr, &AlnsParams::recentSolutions},
+        {"decompositionSize", nullptr, &AlnsParams::decompositionSize},
+        {"decompositionIterations", nullptr, &AlnsParams::decompositionIterations},
+        {"checkpointInterval", nullptr, &AlnsParams::checkpointInterval},
+    };
+    return fields;
+}
+
+// Confere faixas e relações entre campos; lança std::invalid_argument
+inline void checkParams(const AlnsParams &prm)
+{
+    auto require = [](bool ok, const char *msg)
+    {
+        if (!ok)
+            throw std::invalid_argument(std::string("Parametro invalido: ") + msg);
+    };
+    require(prm.maxIter >= 0, "maxIter < 0");
+    require(prm.startTempFactor > 0 && prm.warmStartTempFactor > 0, "fator de temperatura deve ser positivo");
+    require(prm.coolingRate > 0 && prm.coolingRate <= 1, "coolingRate fora de (0, 1]");
+    require(prm.minRemPct > 0 && prm.minRemPct <= prm.maxRemPct && prm.maxRemPct <= 1,
+            "exige 0 < minRemPct <= maxRemPct <= 1");
+    require(prm.reactionFactor >= 0 && prm.reactionFactor <= 1, "reactionFactor fora de [0, 1]");
+    require(prm.segmentSize >= 1 && prm.threads >= 1 && prm.migrationInterval >= 1 && prm.batchSize >= 1 &&
+                prm.repairThreads >= 1 && prm.checkpointInterval >= 1,
+            "segmentSize, threads, migrationInterval, batchSize, repairThreads e checkpointInterval devem ser >= 1");
+    require(prm.recentSolutions >= 0 && prm.recentSolutions <= (1 << 28), "recentSolutions fora de [0, 2^28]");
+    require(prm.decompositionSize >= 0 && prm.decompositionIterations >= 1,
+            "exige decompositionSize >= 0 e decompositionIterations >= 1");
+}
+
+inline void setParam(AlnsParams &prm, const std::string &name, const std::string &value)
+{
+    for (const ParamField &f : paramFields())
+    {
+        if (name != f.name)
+            continue;
+        size_t used = 0;
+        try
+        {
+            if (f.real)
+                prm.*f.real = std::stod(value, &used);
+            else
+                prm.*f.integer = std::stoi(value, &used);
+        }
+        catch (const std::exception &)
+        {
+            used = 0;
+        }
+        if (used == 0 || used != value.size())
+            throw std::invalid_argument("Valor invalido para " + name + ": '" + value + "'");
+        return;
+    }
+    throw std::invalid_argument("Parametro desconhecido: " + name);
+}
+
+inline std::string trimmed(const std::string &s)
+{
+    size_t b = s.find_first_not_of(" \t\r");
+    size_t e = s.find_last_not_of(" \t\r");
+    return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+// "nome=valor" (linha de comando ou linha do arquivo, já sem comentário);
+// devolve o nome atribuído
+inline std::string applyParamAssignment(AlnsParams &prm, const std::string &assignment)
+{
+    size_t eq = assignment.find('=');
+    if (eq == std::string::npos)
+        throw std::invalid_argument("Esperado nome=valor: '" + assignment + "'");
+    std::string name = trimmed(assignment.substr(0, eq));
+    setParam(prm, name, trimmed(assignment.substr(eq + 1)));
+    return name;
+}
+
+// 'assigned' (opcional) recebe os nomes atribuídos pelo arquivo
+inline void loadParamsFile(const std::string &path, AlnsParams &prm, std::vector<std::string> *assigned = nullptr)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("Erro ao abrir a configuracao: " + path);
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo)
+    {
+        line = trimmed(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+        try
+        {
+            std::string name = applyParamAssignment(prm, line);
+            if (assigned)
+                assigned->push_back(name);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            throw std::invalid_argument(path + ":" + std::to_string(lineNo) + ": " + e.what());
+        }
+    }
+}
+
+// Mesmo formato lido por loadParamsFile
+inline void writeParams(const AlnsParams &prm, std::ostream &out)
+{
+    std::streamsize precision = out.precision(10);
+    for (const ParamField &f : paramFields())
+    {
+        out << f.name << " = ";
+        if (f.real)
+            out << prm.*f.real << "\n";
+        else
+            out << prm.*f.integer << "\n";
+    }
+    out.precision(precision);
+}
+
+// ==========================================
+// PERFIL DE EXECUÇÃO (-DALNS_PROFILE)
+// ==========================================
+// Sem a flag, PROFILE_ENABLED é falso e o compilador elimina os blocos
+// "if (PROFILE_ENABLED)" e as leituras de relógio: custo zero na busca.
+
+#ifdef ALNS_PROFILE
+constexpr bool PROFILE_ENABLED = true;
+#else
+constexpr bool PROFILE_ENABLED = false;
+#endif
+
+inline long long profileNow()
+{
+    if (!PROFILE_ENABLED)
+        return 0;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Histograma em potências de 2 de microssegundos: faixa 0 = < 1us,
+// faixa b = [2^(b-1), 2^b) us; a última acumula o restante
+constexpr int PROFILE_BUCKETS = 24;
+
+struct ProfileStat
+{
+    long long calls = 0;
+    long long ns = 0;
+    long long customers = 0; // Removidos (destroy) ou inseridos (repair)
+    long long accepted = 0;  // Candidatos aceitos pelo SA
+    long long newBest = 0;   // Candidatos que melhoraram a melhor solução
+    std::array<long long, PROFILE_BUCKETS> hist{};
+
+    void add(long long elapsedNs)
+    {
+        ++calls;
+        ns += elapsedNs;
+        unsigned long long us = (unsigned long long)std::max(0LL, elapsedNs) / 1000;
+        int b = us == 0 ? 0 : 64 - __builtin_clzll(us);
+        hist[std::min(b, PROFILE_BUCKETS - 1)]++;
+    }
+
+    void merge(const ProfileStat &o)
+    {
+        calls += o.calls;
+        ns += o.ns;
+        customers += o.customers;
+        accepted += o.accepted;
+        newBest += o.newBest;
+        for (int b = 0; b < PROFILE_BUCKETS; ++b)
+            hist[b] += o.hist[b];
+    }
+};
+
+struct AlnsProfile
+{
+    ProfileStat destroy[3];
+    ProfileStat repair[3];
+    ProfileStat copy;       // Cópias de solução (candidatos do lote, melhor solução)
+    ProfileStat acceptance; // Critério do SA e pontuação
+    ProfileStat rollback;   // Desfazer candidatos rejeitados (journal)
+    ProfileStat weights;    // Atualização adaptativa dos pesos
+
+    long long accepted = 0, rejected = 0, infeasible = 0;
+    long long earlyRejected = 0; // Reparos interrompidos pela rejeição antecipada
+    // Pesos ao fim de cada segmento: avaliações, destroy[3], repair[3] (ilha 0)
+    std::vector<std::array<double, 7>> trajectory;
+
+    void merge(const AlnsProfile &o)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            destroy[i].merge(o.destroy[i]);
+            repair[i].merge(o.repair[i]);
+        }
+        copy.merge(o.copy);
+        acceptance.merge(o.acceptance);
+        rollback.merge(o.rollback);
+        weights.merge(o.weights);
+        accepted += o.accepted;
+        rejected += o.rejected;
+        infeasible += o.infeasible;
+        earlyRejected += o.earlyRejected;
+    }
+};
+
+struct AlnsResult
+{
+    Solution best;
+    long long iterations = 0;
+    long long evaluations = 0; // Pares destroy/repair avaliados (iterações x lote)
+    long long duplicates = 0;  // Candidatos já vistos (AlnsParams::recentSolutions)
+    // Evolução do melhor custo: (segundos desde startTotal, custo) a cada melhora
+    std::vector<std::pair<double, long long>> trace;
+    AlnsProfile profile; // Vazio sem -DALNS_PROFILE
+};
+
+inline double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ==========================================
+// ESTADO DA BUSCA, CHECKPOINT E SOLUÇÕES EM ARQUIVO
+// ==========================================
+
+// Tudo que uma busca precisa para continuar exatamente de onde parou
+struct AlnsState
+{
+    Solution current;
+    Solution best;
+    double temperature = 0;
+
+    // Destroy: 0=Random, 1=Worst, 2=Shaw | Repair: 0=Greedy, 1=Regret-2, 2=Regret-3
+    std::vector<double> dWeights{1.0, 1.0, 1.0}, dScores{0.0, 0.0, 0.0};
+    std::vector<double> rWeights{1.0, 1.0, 1.0}, rScores{0.0, 0.0, 0.0};
+    std::vector<int> dCounts{0, 0, 0}, rCounts{0, 0, 0};
+
+    long long iteration = 0;    // Próxima iteração a executar
+    long long evaluations = 0;  // Pares destroy/repair avaliados até aqui
+    long long lastSegment = -1; // Último segmento de pesos fechado
+    std::mt19937 rng;
+};
+
+// Estado inicial de uma busca nova: pesos iguais e T0 proporcional ao custo
+inline AlnsState startState(const Solution &initial, double startTempFactor, uint64_t seed)
+{
+    AlnsState st;
+    st.current = initial;
+    st.best = initial;
+    st.temperature = initial.totalCost * startTempFactor;
+    st.rng.seed(seed);
+    return st;
+}
+
+// Monta uma solução a partir das sequências de clientes de cada slot de rota
+inline Solution solutionFromRoutes(const std::vector<std::vector<int>> &paths, const std::vector<int> &unassigned,
+                                   const Instance &inst)
+{
+    Solution sol;
+    for (const auto &path : paths)
+        sol.routes.push_back(Route{path, 0, 0});
+    sol.unassigned = unassigned;
+    updateSolution(sol, inst);
+    rebuildIndex(sol, inst);
+    return sol;
+}
+
+// Identifica a instância (dimensão, capacidade, coordenadas e demandas), para
+// recusar checkpoints gravados para outra instância
+inline uint64_t instanceFingerprint(const Instance &inst)
+{
+    uint64_t h = 1469598103934665603ULL; // FNV-1a
+    auto mix = [&](const void *p, size_t n)
+    {
+        const unsigned char *b = (const unsigned char *)p;
+        for (size_t i = 0; i < n; ++i)
+            h = (h ^ b[i]) * 1099511628211ULL;
+    };
+    mix(&inst.dimension, sizeof(inst.dimension));
+    mix(&inst.capacity, sizeof(inst.capacity));
+    for (const Node &nd : inst.nodes)
+    {
+        mix(&nd.x, sizeof(nd.x));
+        mix(&nd.y, sizeof(nd.y));
+        mix(&nd.demand, sizeof(nd.demand));
+    }
+    return h;
+}
+
+// Checkpoint em texto: doubles com 17 dígitos (ida e volta exatas) e o estado
+// completo do mt19937. As soluções guardam todos os slots, inclusive os vazios,
+// e a ordem da lista de livres, para a retomada repetir a busca original.
+const char *const CHECKPOINT_MAGIC = "ALNS-CHECKPOINT";
+const int CHECKPOINT_VERSION = 1;
+
+inline void writeCheckpointSolution(std::ostream &out, const char *tag, const Solution &sol)
+{
+    out << tag << " " << sol.totalCost << " " << sol.routes.size() << "\n";
+    for (const auto &r : sol.routes)
+    {
+        out << r.path.size();
+        for (int c : r.path)
+            out << " " << c;
+        out << "\n";
+    }
+    out << sol.freeRoutes.size();
+    for (int f : sol.freeRoutes)
+        out << " " << f;
+    out << "\n" << sol.unassigned.size();
+    for (int c : sol.unassigned)
+        out << " " << c;
+    out << "\n";
+}
+
+inline bool readCheckpointSolution(std::istream &in, const char *tag, const Instance &inst, Solution &sol)
+{
+    std::string word;
+    long long cost;
+    size_t slots, len;
+    if (!(in >> word >> cost >> slots) || word != tag || slots > (size_t)inst.dimension)
+        return false;
+
+    std::vector<std::vector<int>> paths(slots);
+    std::vector<int> freeRoutes, unassigned;
+    std::vector<bool> seen(inst.dimension, false);
+    auto readIds = [&](std::vector<int> &ids, int limit)
+    {
+        if (!(in >> len) || len > (size_t)inst.dimension)
+            return false;
+        ids.resize(len);
+        for (int &v : ids)
+            if (!(in >> v) || v < 0 || v >= limit)
+                return false;
+        return true;
+    };
+    for (auto &path : paths)
+    {
+        if (!readIds(path, inst.dimension))
+            return false;
+        for (int c : path)
+        {
+            if (c == 0 || seen[c])
+                return false;
+            seen[c] = true;
+        }
+    }
+    if (!readIds(freeRoutes, (int)slots) || !readIds(unassigned, inst.dimension))
+        return false;
+
+    sol = solutionFromRoutes(paths, unassigned, inst);
+    std::vector<int> sortedFree = freeRoutes;
+    std::sort(sortedFree.begin(), sortedFree.end());
+    if (sortedFree != sol.freeRoutes || sol.totalCost != cost)
+        return false;
+    sol.freeRoutes = freeRoutes;
+    return true;
+}
+
+// Grava em arquivo temporário e renomeia: um processo interrompido no meio da
+// escrita deixa o checkpoint anterior intacto
+inline bool writeCheckpoint(const AlnsState &st, const Instance &inst, const std::string &path)
+{
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out)
+            return false;
+        out << std::setprecision(17);
+        out << CHECKPOINT_MAGIC << " " << CHECKPOINT_VERSION << "\n";
+        out << "instance " << inst.dimension << " " << instanceFingerprint(inst) << "\n";
+        out << "iteration " << st.iteration << " " << st.evaluations << " " << st.lastSegment << "\n";
+        out << "temperature " << st.temperature << "\n";
+        out << "destroy";
+        for (int i = 0; i < 3; ++i)
+            out << " " << st.dWeights[i] << " " << st.dScores[i] << " " << st.dCounts[i];
+        out << "\nrepair";
+        for (int i = 0; i < 3; ++i)
+            out << " " << st.rWeights[i] << " " << st.rScores[i] << " " << st.rCounts[i];
+        out << "\nrng " << st.rng << "\n";
+        writeCheckpointSolution(out, "current", st.current);
+        writeCheckpointSolution(out, "best", st.best);
+        out << "end\n";
+        if (!out.flush())
+            return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+inline bool readCheckpoint(const std::string &path, const Instance &inst, AlnsState &st)
+{
+    std::ifstream in(path);
+    std::string magic, word;
+    int version, dimension;
+    uint64_t fingerprint;
+    if (!(in >> magic >> version) || magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION)
+        return false;
+    if (!(in >> word >> dimension >> fingerprint) || word != "instance" || dimension != inst.dimension ||
+        fingerprint != instanceFingerprint(inst))
+        return false;
+    if (!(in >> word >> st.iteration >> st.evaluations >> st.lastSegment) || word != "iteration")
+        return false;
+    if (!(in >> word >> st.temperature) || word != "temperature")
+        return false;
+    if (!(in >> word) || word != "destroy")
+        return false;
+    for (int i = 0; i < 3; ++i)
+        in >> st.dWeights[i] >> st.dScores[i] >> st.dCounts[i];
+    if (!(in >> word) || word != "repair")
+        return false;
+    for (int i = 0; i < 3; ++i)
+        in >> st.rWeights[i] >> st.rScores[i] >> st.rCounts[i];
+    if (!(in >> word) || word != "rng" || !(in >> st.rng))
+        return false;
+    return readCheckpointSolution(in, "current", inst, st.current) &&
+           readCheckpointSolution(in, "best", inst, st.best) && (in >> word) && word == "end";
+}
+
+// Solução no formato CVRPLIB: "Route #k: c1 c2 ..." (clientes numerados de 1,
+// ou seja, o índice interno) e "Cost N"
+inline void writeSolutionFile(const Solution &sol, const std::string &path)
+{
+    std::ofstream out(path);
+    int k = 0;
+    for (const auto &r : sol.routes)
+    {
+        if (r.path.empty())
+            continue;
+        out << "Route #" << ++k << ":";
+        for (int c : r.path)
+            out << " " << c;
+        out << "\n";
+    }
+    out << "Cost " << sol.totalCost << "\n";
+}
+
+struct WarmStartReport
+{
+    int routes = 0;
+    int kept = 0;     // Clientes aproveitados nas posições do arquivo
+    int dropped = 0;   // Ids inválidos, repetidos ou acima da capacidade da rota
+    int displaced = 0; // Sem nenhum vizinho granular ao lado na rota (ex.: endereço mudou)
+    int inserted = 0;  // Clientes ausentes, descartados ou deslocados, reinseridos
+};
+
+// Solução inicial a partir de um .sol (CVRPLIB). Tolera uma instância que mudou
+// desde que o arquivo foi gravado: ids fora da faixa ou repetidos são ignorados,
+// rotas que passam da capacidade perdem os clientes excedentes, clientes cujos
+// vizinhos na rota não estão entre os seus vizinhos granulares saem da rota, e
+// todo cliente que ficar de fora é inserido pelo Regret-2. Retorna false se o
+// arquivo não abre.
+inline bool warmStartSolution(const std::string &path, const Instance &inst, Solution &sol, WarmStartReport &report)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    std::vector<std::vector<int>> paths;
+    std::vector<int> unassigned;
+    std::vector<bool> seen(inst.dimension, false);
+    seen[0] = true;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        size_t colon = line.find(':');
+        if (line.rfind("Route", 0) != 0 || colon == std::string::npos)
+            continue;
+        std::istringstream ids(line.substr(colon + 1));
+        std::vector<int> path;
+        int load = 0;
+        long long c;
+        while (ids >> c)
+        {
+            if (c <= 0 || c >= inst.dimension || seen[c])
+            {
+                report.dropped++;
+                continue;
+            }
+            seen[c] = true;
+            if (load + inst.nodes[c].demand > inst.capacity)
+            {
+                report.dropped++;
+                unassigned.push_back(c);
+                continue;
+            }
+            load += inst.nodes[c].demand;
+            path.push_back(c);
+        }
+        if (!path.empty())
+            paths.push_back(std::move(path));
+    }
+    for (int c = 1; c < inst.dimension; ++c)
+        if (!seen[c])
+            unassigned.push_back(c);
+
+    // Um cliente que mudou de lugar fica longe dos dois vizinhos de rota
+    if (inst.neighborK > 0)
+    {
+        auto isNeighbor = [&](int c, int v)
+        {
+            const int *nb = inst.neighborsOf(c);
+            return v != 0 && std::find(nb, nb + inst.neighborK, v) != nb + inst.neighborK;
+        };
+        for (auto &path : paths)
+        {
+            std::vector<int> keep;
+            for (size_t p = 0; p < path.size(); ++p)
+            {
+                int prev = p == 0 ? 0 : path[p - 1];
+                int next = p + 1 == path.size() ? 0 : path[p + 1];
+                if (path.size() > 1 && !isNeighbor(path[p], prev) && !isNeighbor(path[p], next))
+                {
+                    report.displaced++;
+                    unassigned.push_back(path[p]);
+                }
+                else
+                    keep.push_back(path[p]);
+            }
+            path = std::move(keep);
+        }
+    }
+
+    sol = solutionFromRoutes(paths, unassigned, inst);
+    report.routes = (int)(sol.routes.size() - sol.freeRoutes.size());
+    report.inserted = (int)unassigned.size();
+    report.kept = inst.dimension - 1 - report.inserted;
+    if (!sol.unassigned.empty())
+        repairRegret(sol, inst, 2);
+    return true;
+}
+
+// Ponto de encontro das ilhas. Cada ilha publica sua melhor solução no próprio
+// slot e, a cada migração, adota a melhor da ilha anterior no anel caso ela
+// seja melhor que a sua solução corrente. Também serializa o log de "Novo Best".
+class IslandHub
+{
+public:
+    explicit IslandHub(int n) : slots(n), costs(n, std::numeric_limits<long long>::max()) {}
+
+    void publish(int island, const Solution &sol)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (sol.totalCost < costs[island])
+        {
+            slots[island] = sol;
+            costs[island] = sol.totalCost;
+        }
+    }
+
+    // Copia a melhor solução da ilha vizinha se ela custar menos que 'threshold'
+    bool fetchNeighbor(int island, long long threshold, Solution &out)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        int from = (island + (int)slots.size() - 1) % (int)slots.size();
+        if (costs[from] >= threshold)
+            return false;
+        out = slots[from];
+        return true;
+    }
+
+    // Registra um novo melhor local; retorna true se também é o melhor global
+    bool improveGlobal(long long cost)
+    {
+        long long cur = globalBest.load();
+        while (cost < cur)
+            if (globalBest.compare_exchange_weak(cur, cost))
+                return true;
+        return false;
+    }
+
+    std::mutex logMtx;
+
+private:
+    std::mutex mtx;
+    std::vector<Solution> slots;
+    std::vector<long long> costs;
+    std::atomic<long long> globalBest{std::numeric_limits<long long>::max()};
+};
+
+// Soluções completas avaliadas recentemente, pelo hash de arcos. Tabela de
+// mapeamento direto: cada hash ocupa o slot hash & mask e expulsa o anterior,
+// então a memória é fixa e a consulta não aloca. O slot guarda também o custo,
+// que confirma o acerto: uma colisão de 64 bits só conta como repetição se os
+// custos também coincidirem.
+class RecentSolutions
+{
+public:
+    // capacity é arredondada para potência de 2; 0 desliga a tabela
+    explicit RecentSolutions(int capacity)
+    {
+        if (capacity <= 0)
+            return;
+        size_t size = 1;
+        while (size < (size_t)capacity)
+            size <<= 1;
+        table.assign(size, Entry{});
+        mask = size - 1;
+    }
+
+    bool enabled() const { return !table.empty(); }
+
+    // true se a solução já estava na tabela; senão a registra
+    bool seenOrInsert(const Solution &sol)
+    {
+        uint64_t h = sol.arcHash ? sol.arcHash : 1; // 0 marca slot vazio
+        Entry &slot = table[h & mask];
+        if (slot.hash == h && slot.cost == sol.totalCost)
+            return true;
+        slot = {h, sol.totalCost};
+        return false;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t hash = 0;
+        long long cost = 0;
+    };
+
+    std::vector<Entry> table;
+    size_t mask = 0;
+};
+
+const char *const DESTROY_NAMES[] = {"Rnd", "Wst", "Shw"};
+const char *const REPAIR_NAMES[] = {"Grd", "Rg2", "Rg3"};
+
+// Tempos e tamanhos de um par destroy/repair (preenchidos só com ALNS_PROFILE)
+struct OperatorSample
+{
+    long long destroyNs = 0, repairNs = 0;
+    int removed = 0, inserted = 0;
+};
+
+// Limiar de aceitação sorteado antes do reparo: o candidato é aceito se custar
+// menos que 'threshold'; 'rejectAt' é o menor custo inteiro rejeitado
+struct AcceptanceDraw
+{
+    double threshold = std::numeric_limits<double>::infinity();
+    long long rejectAt = std::numeric_limits<long long>::max();
+};
+
+// Aplica um par destroy/repair sobre sol ('gains' acompanha sol, se dado)
+template <class D = DynamicDist>
+inline OperatorSample applyOperators(Solution &sol, int dOp, int rOp, int q, const Instance &inst, std::mt19937 &rng,
+                                     ThreadPool *repairPool = nullptr,
+                                     long long rejectAt = std::numeric_limits<long long>::max(),
+                                     RemovalGainCache *gains = nullptr)
+{
+    OperatorSample sample;
+    long long t0 = profileNow();
+
+    // 3. Destroy
+    if (dOp == 0)
+        destroyRandom<D>(sol, q, inst, rng);
+    else if (dOp == 1)
+        destroyWorst<D>(sol, q, inst, rng, gains);
+    else
+        destroyShaw<D>(sol, q, inst, rng);
+    ALNS_VERIFY(sol, inst, "destroy");
+
+    long long t1 = profileNow();
+    if (PROFILE_ENABLED)
+        sample.removed = (int)sol.unassigned.size();
+
+    // 4. Repair
+    if (rOp == 0)
+        repairGreedy<D>(sol, inst, rng, rejectAt);
+    else if (rOp == 1)
+        repairRegret<D>(sol, inst, 2, repairPool, rejectAt);
+    else
+        repairRegret<D>(sol, inst, 3, repairPool, rejectAt);
+    ALNS_VERIFY(sol, inst, "repair");
+
+    if (PROFILE_ENABLED)
+    {
+        long long t2 = profileNow();
+        sample.destroyNs = t1 - t0;
+        sample.repairNs = t2 - t1;
+        sample.inserted = sample.removed - (int)sol.unassigned.size();
+    }
+    return sample;
+}
+
+// Uma busca ALNS completa (SA + pesos adaptativos) a partir do estado 'st'
+// (startState para uma busca nova, readCheckpoint para retomar uma anterior),
+// que ao final guarda o ponto de parada para uma continuação.
+// Cada chamada tem seu próprio RNG, pesos e temperatura; com hub != nullptr
+// participa do modelo de ilhas. Com prm.batchSize > 1 cada iteração gera
+// K candidatos em paralelo a partir da mesma solução corrente.
+template <class D>
+inline AlnsResult runAlnsWith(const Instance &inst, const AlnsParams &prm, AlnsState &st,
+                              std::chrono::steady_clock::time_point startTotal, IslandHub *hub, int island)
+{
+    std::mt19937 &rng = st.rng;
+    Solution &currentSol = st.current;
+    Solution &bestSol = st.best;
+    double &T = st.temperature;
+    std::vector<double> &dWeights = st.dWeights, &dScores = st.dScores;
+    std::vector<double> &rWeights = st.rWeights, &rScores = st.rScores;
+    std::vector<int> &dCounts = st.dCounts, &rCounts = st.rCounts;
+    bool checkpointing = !prm.checkpointPath.empty() && !hub;
+    auto saveCheckpoint = [&]()
+    {
+        if (!writeCheckpoint(st, inst, prm.checkpointPath))
+            std::cerr << "Falha ao gravar o checkpoint " << prm.checkpointPath << std::endl;
+    };
+    auto reportProgress = [&](long long iter, bool newBest)
+    {
+        AlnsProgress pg{island, iter, secondsSince(startTotal), currentSol.totalCost, bestSol.totalCost, T, newBest};
+        if (!hub)
+            prm.onProgress(pg);
+        else
+        {
+            std::lock_guard<std::mutex> lock(hub->logMtx);
+            prm.onProgress(pg);
+        }
+    };
+
+    // Lote paralelo: cada candidato tem sua cópia da solução e seu próprio RNG
+    struct Candidate
+    {
+        Solution sol;
+        int dOp, rOp, q;
+        AcceptanceDraw draw;
+        uint32_t seed;
+        OperatorSample sample;
+        long long copyNs = 0;
+    };
+    int batch = std::max(1, prm.batchSize);
+    std::vector<Candidate> cands(batch);
+    std::unique_ptr<ThreadPool> pool, repairPool;
+    if (batch > 1)
+        pool.reset(new ThreadPool(std::min<int>(batch, std::max(1u, std::thread::hardware_concurrency()))));
+    else if (prm.repairThreads > 1)
+        repairPool.reset(new ThreadPool(prm.repairThreads));
+
+    int minQ = std::max(1, (int)(inst.dimension * prm.minRemPct));
+    int maxQ = std::max(2, (int)(inst.dimension * prm.maxRemPct));
+
+    RecentSolutions recent(prm.recentSolutions);
+    if (recent.enabled())
+        recent.seenOrInsert(currentSol);
+
+    // Economias do Worst Removal sobre currentSol (só sem lote: os candidatos do
+    // lote são cópias novas a cada iteração). O journal de cada iteração as
+    // mantém; trocas da solução inteira as invalidam.
+    RemovalGainCache gains;
+
+    AlnsResult result;
+    result.trace.emplace_back(secondsSince(startTotal), bestSol.totalCost);
+    long long &evaluations = st.evaluations, &lastSegment = st.lastSegment;
+
+    // Loop Principal (continua da iteração do estado, se retomado)
+    long long firstIter = st.iteration;
+    for (long long &iter = st.iteration; iter < prm.maxIter; ++iter)
+    {
+        // No topo da iteração o estado está completo (journal fechado)
+        if (checkpointing && iter != firstIter && iter % prm.checkpointInterval == 0)
+            saveCheckpoint();
+
+        if (cancelRequested(prm))
+            break;
+        if (secondsSince(startTotal) > prm.maxTimeSeconds)
+        {
+            if (island == 0 && prm.verbose)
+                std::cout << "Tempo limite (" << prm.maxTimeSeconds << "s) atingido." << std::endl;
+            break;
+        }
+
+        // Migração entre ilhas
+        if (hub && iter > 0 && iter % prm.migrationInterval == 0)
+        {
+            hub->publish(island, bestSol);
+            Solution incoming;
+            if (hub->fetchNeighbor(island, currentSol.totalCost, incoming))
+            {
+                currentSol = std::move(incoming);
+                gains.invalidate();
+                if (currentSol.totalCost < bestSol.totalCost)
+                {
+                    bestSol = currentSol;
+                    result.trace.emplace_back(secondsSince(startTotal), bestSol.totalCost);
+                }
+            }
+        }
+
+        long long currentCost = currentSol.totalCost;
+        long long bestCost = bestSol.totalCost;
+
+        // 1. Escolhe Operadores e 2. Define tamanho da vizinhança (q), na thread da busca
+        for (auto &c : cands)
+        {
+            c.dOp = selectOperator(dWeights, rng);
+            c.rOp = selectOperator(rWeights, rng);
+            c.q = std::uniform_int_distribution<>(minQ, maxQ)(rng);
+            if (prm.earlyRejection)
+            {
+                // Aceitar se cand < atual - T·ln(u) equivale a u < exp(-delta / T)
+                double u = std::uniform_real_distribution<>(0.0, 1.0)(rng);
+                c.draw.threshold = currentCost - T * std::log(u);
+                if (c.draw.threshold < 9e18 && inst.metric != EdgeWeight::Explicit)
+                    c.draw.rejectAt = (long long)std::ceil(c.draw.threshold);
+            }
+            if (batch > 1)
+                c.seed = rng();
+        }
+
+        if (batch == 1)
+        {
+            // Candidato é construído sobre currentSol; o journal permite desfazê-lo
+            beginJournal(currentSol);
+            cands[0].sample = applyOperators<D>(currentSol, cands[0].dOp, cands[0].rOp, cands[0].q, inst, rng,
+                                             repairPool.get(), cands[0].draw.rejectAt, &gains);
+        }
+        else
+        {
+            pool->parallelFor(batch, [&](int k)
+                              {
+                Candidate &c = cands[k];
+                long long t0 = profileNow();
+                c.sol = currentSol;
+                c.copyNs = profileNow() - t0;
+                std::mt19937 candRng(c.seed);
+                c.sample = applyOperators<D>(c.sol, c.dOp, c.rOp, c.q, inst, candRng, nullptr, c.draw.rejectAt); });
+        }
+
+        // 5. Aceitação (SA) e Pontuação. Cada candidato é pontuado como se fosse
+        // o único da iteração (mesma referência corrente/melhor); entre os aceitos
+        // adota-se o de menor custo.
+        long long tAccept = profileNow();
+        int adopted = -1;
+        for (int k = 0; k < batch; ++k)
+        {
+            Candidate &c = cands[k];
+            const Solution &cand = (batch == 1) ? currentSol : c.sol;
+            long long candCost = cand.totalCost;
+            double score = 0;
+            bool accepted = false;
+            // Solução repetida: sem pontuação (o uso do operador conta)
+            bool duplicate = cand.unassigned.empty() && recent.enabled() && recent.seenOrInsert(cand);
+            result.duplicates += duplicate;
+            if (cand.unassigned.empty() && !duplicate)
+            { // Verifica validade básica
+                if (candCost < bestCost)
+                {
+                    accepted = true;
+                    score = prm.sigma1;
+                }
+                else if (candCost < currentCost)
+                {
+                    accepted = true;
+                    score = prm.sigma2;
+                }
+                else
+                {
+                    // Com rejeição antecipada, o limiar já foi sorteado antes do reparo
+                    double delta = (double)(candCost - currentCost);
+                    bool pass = prm.earlyRejection
+                                    ? candCost < c.draw.threshold
+                                    : std::uniform_real_distribution<>(0.0, 1.0)(rng) < std::exp(-delta / T);
+                    if (pass)
+                    {
+                        accepted = true;
+                        score = prm.sigma3;
+                    }
+                }
+            }
+
+            dCounts[c.dOp]++;
+            rCounts[c.rOp]++;
+            dScores[c.dOp] += score;
+            rScores[c.rOp] += score;
+            if (accepted && (adopted < 0 || candCost < cands[adopted].sol.totalCost))
+                adopted = k;
+
+            if (PROFILE_ENABLED)
+            {
+                AlnsProfile &pf = result.profile;
+                pf.destroy[c.dOp].add(c.sample.destroyNs);
+                pf.destroy[c.dOp].customers += c.sample.removed;
+                pf.repair[c.rOp].add(c.sample.repairNs);
+                pf.repair[c.rOp].customers += c.sample.inserted;
+                if (batch > 1)
+                    pf.copy.add(c.copyNs);
+                bool improved = accepted && candCost < bestCost;
+                for (ProfileStat *st : {&pf.destroy[c.dOp], &pf.repair[c.rOp]})
+                {
+                    st->accepted += accepted;
+                    st->newBest += improved;
+                }
+                pf.accepted += accepted;
+                pf.rejected += !accepted;
+                bool aborted = !cand.unassigned.empty() && prm.earlyRejection &&
+                               cannotBeat(cand, cand.unassigned.size(), c.draw.rejectAt);
+                pf.infeasible += !cand.unassigned.empty() && !aborted;
+                pf.earlyRejected += aborted;
+            }
+        }
+        evaluations += batch;
+        if (PROFILE_ENABLED)
+            result.profile.acceptance.add(profileNow() - tAccept);
+
+        if (adopted >= 0)
+        {
+            if (batch == 1)
+            {
+                gains.noteJournal(currentSol);
+                commitJournal(currentSol);
+            }
+            else
+                std::swap(currentSol, cands[adopted].sol);
+
+            if (currentSol.totalCost < bestCost)
+            {
+                long long t0 = profileNow();
+                bestSol = currentSol;
+                if (PROFILE_ENABLED)
+                    result.profile.copy.add(profileNow() - t0);
+                result.trace.emplace_back(secondsSince(startTotal), bestSol.totalCost);
+                const char *dName = DESTROY_NAMES[cands[adopted].dOp];
+                const char *rName = REPAIR_NAMES[cands[adopted].rOp];
+                if (prm.verbose && !hub)
+                    std::cout << "Iter " << iter << " | Novo Best: " << bestSol.totalCost << " [" << dName << "+" << rName << "]" << std::endl;
+                else if (prm.verbose && hub->improveGlobal(bestSol.totalCost))
+                {
+                    std::lock_guard<std::mutex> lock(hub->logMtx);
+                    std::cout << "Iter " << iter << " | Novo Best: " << bestSol.totalCost << " [" << dName << "+" << rName << "] (ilha " << island << ")" << std::endl;
+                }
+                if (prm.onProgress)
+                    reportProgress(iter, true);
+            }
+        }
+        else if (batch == 1)
+        {
+            long long t0 = profileNow();
+            gains.noteJournal(currentSol);
+            rollbackJournal<D>(currentSol, inst);
+            if (PROFILE_ENABLED)
+                result.profile.rollback.add(profileNow() - t0);
+            ALNS_VERIFY(currentSol, inst, "rollback");
+        }
+
+        // 6. Atualização Adaptativa de Pesos. Os segmentos contam avaliações
+        // (não iterações), então um lote de K candidatos conta K usos.
+        long long segment = (evaluations - 1) / prm.segmentSize;
+        if (segment != lastSegment)
+        {
+            long long t0 = profileNow();
+            lastSegment = segment;
+            for (int i = 0; i < 3; ++i)
+                if (dCounts[i] > 0)
+                {
+                    dWeights[i] = (1 - prm.reactionFactor) * dWeights[i] + prm.reactionFactor * (dScores[i] / dCounts[i]);
+                    dScores[i] = 0;
+                    dCounts[i] = 0;
+                }
+            for (int i = 0; i < 3; ++i)
+                if (rCounts[i] > 0)
+                {
+                    rWeights[i] = (1 - prm.reactionFactor) * rWeights[i] + prm.reactionFactor * (rScores[i] / rCounts[i]);
+                    rScores[i] = 0;
+                    rCounts[i] = 0;
+                }
+            if (PROFILE_ENABLED)
+            {
+                result.profile.weights.add(profileNow() - t0);
+                if (island == 0)
+                    result.profile.trajectory.push_back({(double)evaluations, dWeights[0], dWeights[1], dWeights[2],
+                                                         rWeights[0], rWeights[1], rWeights[2]});
+            }
+        }
+
+        // Resfriamento
+        T *= prm.coolingRate;
+        if (T < 0.001)
+            T = currentSol.totalCost * 0.001; // Reheat suave para evitar congelamento total
+
+        result.iterations++;
+        if (prm.onProgress && prm.progressInterval > 0 && (iter + 1) % prm.progressInterval == 0)
+            reportProgress(iter + 1, false);
+    }
+
+    if (hub)
+        hub->publish(island, bestSol);
+    if (checkpointing)
+        saveCheckpoint();
+    result.best = bestSol;
+    result.evaluations = evaluations;
+    return result;
+}
+
+// Escolhe uma vez o acessor de distâncias da instância e roda a busca com ele
+inline AlnsResult runAlns(const Instance &inst, const AlnsParams &prm, AlnsState &st,
+                          std::chrono::steady_clock::time_point startTotal, IslandHub *hub = nullptr, int island = 0)
+{
+    return withDistAccess(inst.dist, [&](auto dist)
+                          { return runAlnsWith<decltype(dist)>(inst, prm, st, startTotal, hub, island); });
+}
+
+// Semente do fluxo 'stream' derivada de 'seed' (ilhas, execuções independentes)
+inline uint32_t deriveSeed(uint64_t seed, uint64_t stream)
+{
+    std::seed_seq seq{seed, stream};
+    uint32_t out;
+    seq.generate(&out, &out + 1);
+    return out;
+}
+
+inline AlnsResult solveDecomposed(const Instance &inst, const AlnsParams &prm, const Solution &initial,
+                                  uint64_t seed, std::chrono::steady_clock::time_point startTotal);
+
+// Executa prm.threads ilhas em paralelo (ou uma busca simples) e devolve a melhor
+// solução encontrada; 'iterations' soma as iterações de todas as ilhas. Com
+// prm.decompositionSize > 0, delega a solveDecomposed.
+inline AlnsResult solve(const Instance &inst, const AlnsParams &prm, const Solution &initial, uint64_t seed,
+                        std::chrono::steady_clock::time_point startTotal)
+{
+    if (prm.decompositionSize > 0)
+        return solveDecomposed(inst, prm, initial, seed, startTotal);
+    if (prm.threads <= 1)
+    {
+        AlnsState st = startState(initial, prm.startTempFactor, seed);
+        return runAlns(inst, prm, st, startTotal);
+    }
+
+    IslandHub hub(prm.threads);
+    std::vector<AlnsResult> results(prm.threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < prm.threads; ++t)
+    {
+        // Fluxos de números aleatórios distintos por ilha
+        uint32_t islandSeed = deriveSeed(seed, t);
+        workers.emplace_back([&, t, islandSeed]()
+                             {
+            AlnsState st = startState(initial, prm.startTempFactor, islandSeed);
+            results[t] = runAlns(inst, prm, st, startTotal, &hub, t); });
+    }
+    for (auto &w : workers)
+        w.join();
+
+    AlnsResult best = std::move(results[0]);
+    for (int t = 1; t < prm.threads; ++t)
+    {
+        best.iterations += results[t].iterations;
+        best.evaluations += results[t].evaluations;
+        best.duplicates += results[t].duplicates;
+        best.trace.insert(best.trace.end(), results[t].trace.begin(), results[t].trace.end());
+        best.profile.merge(results[t].profile);
+        if (results[t].best.totalCost < best.best.totalCost)
+            best.best = std::move(results[t].best);
+    }
+
+    // Traço global: melhoras de qualquer ilha em ordem de tempo
+    std::sort(best.trace.begin(), best.trace.end());
+    std::vector<std::pair<double, long long>> merged;
+    for (const auto &pt : best.trace)
+        if (merged.empty() || pt.second < merged.back().second)
+            merged.push_back(pt);
+    best.trace = std::move(merged);
+    return best;
+}
+
+// ==========================================
+// EXECUÇÕES INDEPENDENTES (VALIDAÇÃO ESTATÍSTICA)
+// ==========================================
+
+struct RunRecord
+{
+    int run;
+    uint32_t seed; // Reproduz a execução isolada com --seed
+    long long cost;
+    double seconds;
+    long long iterations;
+};
+
+struct MultiRunSummary
+{
+    std::vector<RunRecord> runs;
+    Solution best;
+    double meanCost = 0, stdevCost = 0, ciHalfWidth = 0; // IC: z * desvio / sqrt(n)
+    double meanSeconds = 0, meanIterations = 0;
+    long long minCost = 0, maxCost = 0;
+};
+
+// 'runs' buscas independentes sobre a mesma instância já carregada, em paralelo
+// num pool de 'poolSize' threads. A execução r usa deriveSeed(seed, r), então
+// o resultado não depende da ordem em que as execuções terminam.
+inline MultiRunSummary solveMany(const Instance &inst, const AlnsParams &prm, const Solution &initial, uint64_t seed,
+                                 int runs, int poolSize, double z = 1.96)
+{
+    MultiRunSummary out;
+    out.runs.resize(runs);
+    std::vector<Solution> bests(runs);
+    ThreadPool pool(std::max(1, std::min(poolSize, runs)));
+    pool.parallelFor(runs, [&](int r)
+                     {
+        uint32_t runSeed = deriveSeed(seed, r);
+        auto start = std::chrono::steady_clock::now();
+        AlnsResult res = solve(inst, prm, initial, runSeed, start);
+        out.runs[r] = {r, runSeed, res.best.totalCost, secondsSince(start), res.iterations};
+        bests[r] = std::move(res.best); });
+
+    int bestRun = 0;
+    double sum = 0, sumSec = 0, sumIt = 0;
+    out.minCost = out.maxCost = out.runs[0].cost;
+    for (const RunRecord &rr : out.runs)
+    {
+        sum += rr.cost;
+        sumSec += rr.seconds;
+        sumIt += rr.iterations;
+        out.minCost = std::min(out.minCost, rr.cost);
+        out.maxCost = std::max(out.maxCost, rr.cost);
+        if (rr.cost < out.runs[bestRun].cost)
+            bestRun = rr.run;
+    }
+    out.meanCost = sum / runs;
+    out.meanSeconds = sumSec / runs;
+    out.meanIterations = sumIt / runs;
+    double sq = 0;
+    for (const RunRecord &rr : out.runs)
+        sq += (rr.cost - out.meanCost) * (rr.cost - out.meanCost);
+    out.stdevCost = runs > 1 ? std::sqrt(sq / (runs - 1)) : 0;
+    out.ciHalfWidth = z * out.stdevCost / std::sqrt((double)runs);
+    out.best = std::move(bests[bestRun]);
+    return out;
+}
+
+// ==========================================
+// RELATÓRIO DE PERFIL
+// ==========================================
+
+// Tabela por operador/etapa; 'seconds' é o tempo de parede da busca (soma das
+// threads quando há ilhas ou lote, por isso as porcentagens podem passar de 100)
+inline void printProfile(const AlnsProfile &pf, double seconds, std::ostream &out)
+{
+    out << "\n--- Perfil (" << std::fixed << std::setprecision(2) << seconds << "s de busca) ---\n";
+    out << std::left << std::setw(12) << "Etapa" << std::right << std::setw(10) << "Chamadas" << std::setw(10) << "Tempo(s)"
+        << std::setw(8) << "%" << std::setw(11) << "Media(us)" << std::setw(10) << "Clientes" << std::setw(9)
+        << "Aceito%" << std::setw(8) << "Best" << "\n";
+
+    auto row = [&](const std::string &name, const ProfileStat &st, bool isOperator)
+    {
+        if (st.calls == 0)
+            return;
+        out << std::left << std::setw(12) << name << std::right << std::setw(10) << st.calls << std::setw(10)
+            << std::setprecision(3) << st.ns * 1e-9 << std::setw(8) << std::setprecision(1)
+            << 100.0 * st.ns * 1e-9 / seconds << std::setw(11) << std::setprecision(1) << st.ns * 1e-3 / st.calls;
+        if (isOperator)
+            out << std::setw(10) << std::setprecision(1) << (double)st.customers / st.calls << std::setw(9)
+                << 100.0 * st.accepted / st.calls << std::setw(8) << st.newBest;
+        out << "\n";
+    };
+    for (int i = 0; i < 3; ++i)
+        row(std::string("destroy ") + DESTROY_NAMES[i], pf.destroy[i], true);
+    for (int i = 0; i < 3; ++i)
+        row(std::string("repair ") + REPAIR_NAMES[i], pf.repair[i], true);
+    row("copia", pf.copy, false);
+    row("aceitacao", pf.acceptance, false);
+    row("rollback", pf.rollback, false);
+    row("pesos", pf.weights, false);
+
+    long long total = pf.accepted + pf.rejected;
+    if (total > 0)
+        out << "Aceitos: " << pf.accepted << " (" << std::setprecision(1) << 100.0 * pf.accepted / total
+            << "%) | Rejeitados: " << pf.rejected << " (antecipados: " << pf.earlyRejected
+            << ") | Inviaveis: " << pf.infeasible << "\n";
+    if (!pf.trajectory.empty())
+    {
+        const auto &w = pf.trajectory.back();
+        out << "Pesos finais: destroy";
+        for (int i = 0; i < 3; ++i)
+            out << " " << DESTROY_NAMES[i] << "=" << std::setprecision(2) << w[1 + i];
+        out << " | repair";
+        for (int i = 0; i < 3; ++i)
+            out << " " << REPAIR_NAMES[i] << "=" << std::setprecision(2) << w[4 + i];
+        out << "\n";
+    }
+    out << std::setprecision(6) << std::defaultfloat;
+}
+
+inline void writeProfileJson(const AlnsProfile &pf, double seconds, const std::string &path)
+{
+    std::ofstream out(path);
+    auto stat = [&](const std::string &name, const ProfileStat &st)
+    {
+        out << "    \"" << name << "\": {\"calls\": " << st.calls << ", \"ns\": " << st.ns
+            << ", \"customers\": " << st.customers << ", \"accepted\": " << st.accepted
+            << ", \"newBest\": " << st.newBest << ", \"histUs\": [";
+        for (int b = 0; b < PROFILE_BUCKETS; ++b)
+            out << (b ? ", " : "") << st.hist[b];
+        out << "]}";
+    };
+
+    out << "{\n  \"seconds\": " << seconds << ",\n  \"accepted\": " << pf.accepted << ",\n  \"rejected\": "
+        << pf.rejected << ",\n  \"early_rejected\": " << pf.earlyRejected << ",\n  \"infeasible\": " << pf.infeasible
+        << ",\n  \"stats\": {\n";
+    for (int i = 0; i < 3; ++i)
+    {
+        stat(std::string("destroy") + DESTROY_NAMES[i], pf.destroy[i]);
+        out << ",\n";
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        stat(std::string("repair") + REPAIR_NAMES[i], pf.repair[i]);
+        out << ",\n";
+    }
+    stat("copy", pf.copy);
+    out << ",\n";
+    stat("acceptance", pf.acceptance);
+    out << ",\n";
+    stat("rollback", pf.rollback);
+    out << ",\n";
+    stat("weights", pf.weights);
+    out << "\n  },\n  \"weightTrajectory\": [";
+    for (size_t i = 0; i < pf.trajectory.size(); ++i)
+    {
+        const auto &w = pf.trajectory[i];
+        out << (i ? ",\n" : "\n") << "    [" << (long long)w[0];
+        for (int j = 1; j < 7; ++j)
+            out << ", " << w[j];
+        out << "]";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// ==========================================
+// API DE BIBLIOTECA
+// ==========================================
+
+// Instância montada em memória (ex.: pedido recebido por um serviço), sem .vrp.
+// nodes[0] é o depósito; os ids passam a ser as posições no vetor.
+inline Instance makeInstance(std::vector<Node> nodes, int capacity,
+                             DistMatrix::Layout layout = DistMatrix::Layout::Full, int granularK = 30,
+                             EdgeWeight metric = EdgeWeight::Euc2D)
+{
+    if (metric == EdgeWeight::Explicit)
+        throw std::invalid_argument("makeInstance: a metrica deve ser de coordenadas (EUC_2D ou CEIL_2D)");
+    if (nodes.size() < 2)
+        throw std::invalid_argument("makeInstance: sao necessarios o deposito e ao menos um cliente");
+    if (capacity <= 0)
+        throw std::invalid_argument("makeInstance: capacidade deve ser positiva");
+    for (size_t i = 1; i < nodes.size(); ++i)
+        if (nodes[i].demand < 0 || nodes[i].demand > capacity)
+            throw std::invalid_argument("makeInstance: demanda do cliente " + std::to_string(i) +
+                                        " fora de [0, capacidade]");
+
+    Instance inst;
+    inst.dimension = (int)nodes.size();
+    inst.capacity = capacity;
+    inst.metric = metric;
+    inst.nodes = std::move(nodes);
+    for (int i = 0; i < inst.dimension; ++i)
+        inst.nodes[i].id = i;
+    buildDistanceMatrix(inst, layout);
+    buildNeighborLists(inst, granularK);
+    return inst;
+}
+
+// Solver reentrante: configuração (AlnsParams, incluindo orçamento de tempo e
+// iterações e o callback de progresso), semente explícita por chamada e
+// cancelamento. Não há estado global, então solves simultâneos no mesmo
+// processo são seguros, inclusive sobre a mesma Instance (somente leitura) e
+// pelo mesmo AlnsSolver; cancel() interrompe os solves dele em andamento
+// naquele momento e não afeta os que começarem depois.
+class AlnsSolver
+{
+public:
+    // Sem parâmetros: valores padrão, sem impressão em stdout
+    AlnsSolver() { prm.verbose = false; }
+    explicit AlnsSolver(AlnsParams params) : prm(std::move(params)) {}
+
+    AlnsParams &params() { return prm; }
+    const AlnsParams &params() const { return prm; }
+
+    // Busca a partir do vizinho mais próximo
+    AlnsResult solve(const Instance &inst, uint64_t seed) { return solve(inst, initialSolution(inst), seed); }
+
+    // Busca a partir de uma solução dada (ex.: warmStartSolution)
+    AlnsResult solve(const Instance &inst, const Solution &initial, uint64_t seed)
+    {
+        AlnsParams run = prm;
+        run.cancelEpoch = &cancelEpoch;
+        run.cancelEpochAtStart = cancelEpoch.load();
+        return ::solve(inst, run, initial, seed, std::chrono::steady_clock::now());
+    }
+
+    // Seguro a partir de qualquer thread; cada solve em andamento retorna a
+    // melhor solução encontrada até ali (em no máximo uma iteração). Sem solve
+    // em andamento não tem efeito.
+    void cancel() { cancelEpoch.fetch_add(1); }
+
+private:
+    AlnsParams prm;
+    std::atomic<uint64_t> cancelEpoch{0};
+};
+
+// Plano dinâmico para reotimização ao longo do dia: pedidos chegam e são
+// cancelados com as rotas em execução. Guarda a instância, o estado da busca
+// (soluções, pesos, temperatura, RNG) e as travas entre as alterações. Cada
+// alteração custa O(n) distâncias mais O(n·K) nas listas granulares: a matriz
+// cresce no lugar (ids de clientes retirados são reaproveitados) e só as
+// listas afetadas são refeitas. A alteração vale na melhor solução, que passa
+// a ser a corrente; reoptimize() roda uma rajada curta de ALNS que continua
+// os pesos e a temperatura da anterior. Não é reentrante (uma thread por
+// plano), exceto cancel().
+class DynamicPlan
+{
+public:
+    // 'plan' é uma solução de 'instance' (ex.: resultado de AlnsSolver::solve);
+    // clientes não atendidos nela são inseridos de imediato. A temperatura
+    // inicial usa params.warmStartTempFactor, como em --init.
+    DynamicPlan(Instance instance, const Solution &plan, AlnsParams params, uint64_t seed)
+        : inst(std::move(instance)), prm(std::move(params))
+    {
+        int n = inst.dimension;
+        if ((int)plan.routeOf.size() != n)
+            throw std::invalid_argument("DynamicPlan: solucao nao pertence a instancia");
+
+        // Cópia privada da matriz com folga; a grade espacial (modo sem matriz)
+        // acompanha as inclusões e remoções de clientes
+        inst.dist.reserve(n + n / 4 + 16, false);
+        inst.locked.assign(n, 0);
+        inst.lockedCount = 0;
+        present.assign(n, 1);
+        present[0] = 0;
+        listedBy.assign(n, {});
+        for (int v = 0; v < n; ++v)
+            for (int k = 0; k < inst.neighborK; ++k)
+                listedBy[inst.neighborsOf(v)[k]].push_back(v);
+
+        Solution initial = plan;
+        if (!initial.unassigned.empty())
+            repairRegret(initial, inst, 2);
+        st = startState(initial, prm.warmStartTempFactor, seed);
+        currentIsBest = true;
+    }
+
+    // Novo cliente, inserido na posição de menor custo do plano. Devolve seu id.
+    int addCustomer(double x, double y, int demand)
+    {
+        if (demand < 0 || demand > inst.capacity)
+            throw std::invalid_argument("DynamicPlan: demanda fora de [0, capacidade]");
+        if (inst.metric == EdgeWeight::Explicit)
+            throw std::invalid_argument("DynamicPlan: instancia EXPLICIT nao tem distancias para novos clientes");
+
+        int c;
+        if (!freeIds.empty())
+        {
+            c = freeIds.back();
+            freeIds.pop_back();
+        }
+        else
+        {
+            c = inst.dimension++;
+            inst.nodes.emplace_back();
+            inst.dist.resize(inst.dimension);
+            inst.neighbors.resize((size_t)inst.dimension * inst.neighborK, 0);
+            inst.locked.push_back(0);
+            present.push_back(0);
+            listedBy.emplace_back();
+            for (Solution *s : {&st.best, &st.current})
+            {
+                s->routeOf.push_back(-1);
+                s->posOf.push_back(-1);
+            }
+        }
+        inst.nodes[c] = {c, x, y, demand};
+        setDistances(c);
+        if (!inst.grid.empty())
+            placeInGrid(c);
+
+        present[c] = 1;
+        if (inst.neighborK > 0)
+        {
+            refreshNeighbors(c);
+            for (int v = 0; v < inst.dimension; ++v)
+                if (v != c && (v == 0 || present[v]))
+                    offerNeighbor(v, c);
+        }
+
+        // O reparo só mexe na rota que recebe c; a corrente repete as mesmas inserções
+        syncCurrent();
+        for (Solution *s : {&st.best, &st.current})
+        {
+            s->unassigned.push_back(c);
+            s->totalCost += UNASSIGNED_PENALTY;
+        }
+        beginJournal(st.best);
+        repairRegret(st.best, inst, 2);
+        replayOnCurrent();
+        return c;
+    }
+
+    // Cancela o cliente c: sai da sua rota e o id fica livre para reuso
+    void removeCustomer(int c)
+    {
+        checkCustomer(c);
+        syncCurrent();
+        for (Solution *s : {&st.best, &st.current})
+        {
+            if (::removeCustomerById(*s, c, inst))
+            {
+                s->unassigned.pop_back();
+                s->totalCost -= UNASSIGNED_PENALTY;
+            }
+            else
+            {
+                // Ainda fora das rotas (reparo interrompido): só sai da lista de pendentes
+                auto it = std::find(s->unassigned.begin(), s->unassigned.end(), c);
+                if (it != s->unassigned.end())
+                {
+                    s->unassigned.erase(it);
+                    s->totalCost -= UNASSIGNED_PENALTY;
+                }
+            }
+        }
+
+        unlockCustomer(c);
+        present[c] = 0;
+        freeIds.push_back(c);
+        if (!inst.grid.empty())
+            inst.grid.remove(c);
+        // Listas que apontavam para c são refeitas sem ele
+        if (inst.neighborK > 0)
+        {
+            std::vector<int> stale = listedBy[c];
+            for (int v : stale)
+                refreshNeighbors(v);
+            // A lista do próprio c só volta a valer quando o id for reusado
+            const int *nb = inst.neighborsOf(c);
+            for (int k = 0; k < inst.neighborK; ++k)
+                unlist(nb[k], c);
+        }
+    }
+
+    // Cliente travado continua na rota em que está (ex.: já carregado no
+    // veículo); outros clientes ainda podem ser inseridos antes ou depois dele
+    void lockCustomer(int c)
+    {
+        checkCustomer(c);
+        if (!inst.locked[c])
+        {
+            inst.locked[c] = 1;
+            inst.lockedCount++;
+        }
+    }
+
+    void unlockCustomer(int c)
+    {
+        checkCustomer(c);
+        if (inst.locked[c])
+        {
+            inst.locked[c] = 0;
+            inst.lockedCount--;
+        }
+    }
+
+    // Rajada de ALNS de até 'seconds' (e até params.maxIter iterações) a partir
+    // do plano atual; devolve o melhor plano, que também fica em solution()
+    AlnsResult reoptimize(double seconds)
+    {
+        AlnsParams run = prm;
+        run.maxTimeSeconds = seconds;
+        run.maxIter = (int)std::min<long long>(std::numeric_limits<int>::max(), st.iteration + prm.maxIter);
+        run.checkpointPath.clear(); // A instância alterada não corresponde a nenhum arquivo
+        run.cancelEpoch = &cancelEpoch;
+        run.cancelEpochAtStart = cancelEpoch.load();
+        AlnsResult res = runAlns(inst, run, st, std::chrono::steady_clock::now());
+        currentIsBest = false;
+        return res;
+    }
+
+    // Seguro a partir de qualquer thread: encerra a rajada em andamento (sem
+    // rajada em andamento não tem efeito)
+    void cancel() { cancelEpoch.fetch_add(1); }
+
+    bool isCustomer(int c) const { return c > 0 && c < inst.dimension && present[c]; }
+    const Solution &solution() const { return st.best; }
+    const Instance &instance() const { return inst; }
+    const AlnsState &state() const { return st; }
+
+private:
+    void checkCustomer(int c) const
+    {
+        if (!isCustomer(c))
+            throw std::invalid_argument("DynamicPlan: cliente inexistente: " + std::to_string(c));
+    }
+
+    // Linha e coluna de c contra todos os nós (inclusive ids livres, sobrescritos no reuso)
+    void setDistances(int c)
+    {
+        DistMatrix &dist = inst.dist;
+        if (dist.getLayout() == DistMatrix::Layout::OnTheFly)
+        {
+            dist.setPoint(c, inst.nodes[c].x, inst.nodes[c].y);
+            return;
+        }
+        std::vector<long long> row(inst.dimension);
+        long long maxDist = 0;
+        withMetric(inst.metric, [&](auto metric)
+                   {
+            using M = decltype(metric);
+            for (int j = 0; j < inst.dimension; ++j)
+            {
+                row[j] = (j == c) ? 0 : calculateDistance<M>(inst.nodes[c], inst.nodes[j]);
+                maxDist = std::max(maxDist, row[j]);
+            } });
+        if (!dist.isWide() && maxDist + 1 > std::numeric_limits<int32_t>::max() / 4)
+            dist.reserve(inst.dimension, true);
+        bool full = dist.getLayout() == DistMatrix::Layout::Full;
+        for (int j = 0; j < inst.dimension; ++j)
+        {
+            dist.set(c, j, row[j]);
+            if (full)
+                dist.set(j, c, row[j]);
+        }
+    }
+
+    // Ordem das listas: distância e, no empate, menor id; 0 completa listas
+    // maiores que o número de clientes (nunca roteado, ignorado pelos operadores)
+    bool closer(int v, int a, int b) const
+    {
+        if (b == 0)
+            return a != 0;
+        if (a == 0)
+            return false;
+        long long da = inst.dist(v, a), db = inst.dist(v, b);
+        return da < db || (da == db && a < b);
+    }
+
+    // Refaz a lista de v (pela grade, se houver; senão varrendo os clientes)
+    void refreshNeighbors(int v)
+    {
+        std::vector<int> cand;
+        if (!inst.grid.empty())
+            inst.grid.kNearest(v, inst.neighborK, inst.dist, cand); // Só clientes presentes
+        else
+        {
+            for (int j = 1; j < inst.dimension; ++j)
+                if (j != v && present[j])
+                    cand.push_back(j);
+            int k = std::min<int>(inst.neighborK, cand.size());
+            std::partial_sort(cand.begin(), cand.begin() + k, cand.end(), [&](int a, int b)
+                              { return closer(v, a, b); });
+        }
+        cand.resize(inst.neighborK, 0);
+        int *nb = inst.neighbors.data() + (size_t)v * inst.neighborK;
+        for (int k = 0; k < inst.neighborK; ++k)
+            unlist(nb[k], v);
+        std::copy(cand.begin(), cand.end(), nb);
+        for (int k = 0; k < inst.neighborK; ++k)
+            listedBy[nb[k]].push_back(v);
+    }
+
+    // Entra c na lista de v se for mais próximo que o último
+    void offerNeighbor(int v, int c)
+    {
+        int *nb = inst.neighbors.data() + (size_t)v * inst.neighborK;
+        int k = inst.neighborK - 1;
+        if (!closer(v, c, nb[k]))
+            return;
+        unlist(nb[k], v);
+        listedBy[c].push_back(v);
+        for (; k > 0 && closer(v, c, nb[k - 1]); --k)
+            nb[k] = nb[k - 1];
+        nb[k] = c;
+    }
+
+    // Índice inverso: tira uma ocorrência de v das listas que contêm u
+    void unlist(int u, int v)
+    {
+        auto &l = listedBy[u];
+        auto it = std::find(l.begin(), l.end(), v);
+        if (it != l.end())
+        {
+            *it = l.back();
+            l.pop_back();
+        }
+    }
+
+    // Põe c na grade; a lista à parte (ids novos ou que mudaram de célula) é
+    // varrida por toda busca, então a grade é refeita quando ela passa de n/16
+    void placeInGrid(int c)
+    {
+        inst.grid.insert(c, inst.nodes[c].x, inst.nodes[c].y);
+        if ((int)inst.grid.overflow() * 16 <= inst.dimension)
+            return;
+        inst.grid.build(inst.nodes, inst.dimension);
+        for (int v = 1; v < inst.dimension; ++v)
+            if (!present[v] && v != c)
+                inst.grid.remove(v);
+    }
+
+    // Os eventos valem para a melhor solução e para a corrente, que passa a ser
+    // igual a ela. A cópia inteira só acontece no primeiro evento depois de uma
+    // rajada; os seguintes repetem na corrente as alterações da melhor.
+    void syncCurrent()
+    {
+        if (!currentIsBest)
+            st.current = st.best;
+        currentIsBest = true;
+    }
+
+    // Repete na corrente as alterações registradas no journal da melhor
+    void replayOnCurrent()
+    {
+        for (const UndoEntry &e : st.best.journal)
+        {
+            if (e.inserted)
+            {
+                auto &pending = st.current.unassigned;
+                pending.erase(std::find(pending.begin(), pending.end(), e.customer));
+                // Rota aberta no fim do vetor: a corrente abre a sua no mesmo índice
+                int r = e.routeIndex < (int)st.current.routes.size() ? e.routeIndex : NEW_ROUTE;
+                ::insertCustomer(st.current, r, e.position, e.customer, inst);
+            }
+            else
+                ::removeCustomer(st.current, e.routeIndex, e.position, inst);
+        }
+        commitJournal(st.best);
+        ALNS_VERIFY(st.current, inst, "DynamicPlan");
+#ifdef ALNS_DEBUG
+        bool same = st.current.totalCost == st.best.totalCost && st.current.routes.size() == st.best.routes.size();
+        for (size_t r = 0; same && r < st.best.routes.size(); ++r)
+            same = st.current.routes[r].path == st.best.routes[r].path;
+        if (!same)
+        {
+            std::cerr << "DynamicPlan: solucao corrente diverge da melhor" << std::endl;
+            std::abort();
+        }
+#endif
+    }
+
+    Instance inst;
+    AlnsParams prm;
+    AlnsState st;
+    std::vector<char> present;              // Id em uso por um cliente ativo
+    std::vector<int> freeIds;               // Ids de clientes retirados, para reuso
+    std::vector<std::vector<int>> listedBy; // [u] = nós cuja lista de vizinhos contém u
+    bool currentIsBest = false;             // st.current == st.best (até a próxima rajada)
+    std::atomic<uint64_t> cancelEpoch{0};
+};
+
+// ==========================================
+// DECOMPOSIÇÃO (INSTÂNCIAS GRANDES)
+// ==========================================
+// Com milhares de clientes, cada iteração sobre a instância inteira custa caro
+// e mexe em uma fração pequena dela. A decomposição reparte a melhor solução em
+// grupos de rotas vizinhas (ordem do ângulo do baricentro de cada rota em torno
+// do depósito), monta uma subinstância por grupo (depósito + seus clientes) e
+// roda o ALNS em cada uma, em paralelo. Os grupos não compartilham clientes nem
+// rotas, então as melhores rotas de cada subproblema formam a nova solução, que
+// nunca piora. Cada rodada começa os grupos em outra rota, para que as
+// fronteiras mudem. O custo de uma rodada cresce linearmente com n.
+
+// Grupos de rotas não vazias consecutivas na ordem angular, com cerca de
+// targetSize clientes cada, a partir da rota 'offset' dessa ordem
+inline std::vector<std::vector<int>> groupRoutesByAngle(const Solution &sol, const Instance &inst, int targetSize,
+                                                        int offset)
+{
+    const Node &depot = inst.nodes[0];
+    std::vector<std::pair<double, int>> order; // (ângulo, rota)
+    for (int r = 0; r < (int)sol.routes.size(); ++r)
+    {
+        const std::vector<int> &path = sol.routes[r].path;
+        if (path.empty())
+            continue;
+        double x = 0, y = 0;
+        for (int c : path)
+        {
+            x += inst.nodes[c].x;
+            y += inst.nodes[c].y;
+        }
+        order.emplace_back(std::atan2(y / path.size() - depot.y, x / path.size() - depot.x), r);
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<std::vector<int>> groups;
+    int size = 0; // Clientes do último grupo
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        int r = order[(i + offset) % order.size()].second;
+        if (groups.empty() || size >= targetSize)
+        {
+            groups.emplace_back();
+            size = 0;
+        }
+        groups.back().push_back(r);
+        size += (int)sol.routes[r].path.size();
+    }
+    // Sobra pequena no fim da volta vai para o grupo anterior
+    if (groups.size() > 1 && size < targetSize / 2)
+    {
+        std::vector<int> &prev = groups[groups.size() - 2];
+        prev.insert(prev.end(), groups.back().begin(), groups.back().end());
+        groups.pop_back();
+    }
+    return groups;
+}
+
+// Subinstância de um grupo de rotas (matriz completa): o nó local i é o nó
+// global[i] da original
+struct Subproblem
+{
+    Instance inst;
+    std::vector<int> global;
+    Solution initial; // As rotas do grupo, em ids locais
+};
+
+inline Subproblem buildSubproblem(const Solution &sol, const std::vector<int> &routes, const Instance &inst)
+{
+    Subproblem sp;
+    std::vector<Node> nodes{inst.nodes[0]};
+    std::vector<std::vector<int>> paths;
+    sp.global.push_back(0);
+    for (int r : routes)
+    {
+        paths.emplace_back();
+        for (int c : sol.routes[r].path)
+        {
+            paths.back().push_back((int)sp.global.size());
+            sp.global.push_back(c);
+            nodes.push_back(inst.nodes[c]);
+        }
+    }
+    // Distâncias copiadas da instância original: vale para qualquer métrica
+    // (inclusive EXPLICIT) e evita recalcular raízes
+    int m = (int)nodes.size();
+    sp.inst.dimension = m;
+    sp.inst.capacity = inst.capacity;
+    sp.inst.metric = inst.metric;
+    sp.inst.nodes = std::move(nodes);
+    sp.inst.dist.allocate(m, DistMatrix::Layout::Full, inst.dist.isWide());
+    for (int i = 0; i < m; ++i)
+    {
+        sp.inst.nodes[i].id = i;
+        for (int j = 0; j < m; ++j)
+            sp.inst.dist.set(i, j, inst.dist(sp.global[i], sp.global[j]));
+    }
+    buildNeighborLists(sp.inst, inst.neighborK);
+    if (inst.lockedCount > 0)
+    {
+        sp.inst.locked.assign(sp.inst.dimension, 0);
+        for (int i = 1; i < sp.inst.dimension; ++i)
+            if (inst.isLocked(sp.global[i]))
+            {
+                sp.inst.locked[i] = 1;
+                ++sp.inst.lockedCount;
+            }
+    }
+    sp.initial = solutionFromRoutes(paths, {}, sp.inst);
+    return sp;
+}
+
+// Rodadas de decomposição até prm.maxIter iterações por região, o tempo limite
+// ou o cancelamento. Os subproblemas de uma rodada usam sementes derivadas de
+// (seed, rodada, grupo), então o resultado não depende de prm.threads.
+inline AlnsResult solveDecomposed(const Instance &inst, const AlnsParams &prm, const Solution &initial,
+                                  uint64_t seed, std::chrono::steady_clock::time_point startTotal)
+{
+    AlnsParams sub = prm;
+    sub.decompositionSize = 0;
+    if (inst.dimension - 1 <= prm.decompositionSize)
+        return solve(inst, sub, initial, seed, startTotal); // Um grupo só: busca comum
+
+    sub.maxIter = prm.decompositionIterations;
+    sub.threads = 1;
+    sub.batchSize = 1;
+    sub.repairThreads = 1;
+    sub.verbose = false;
+    sub.checkpointPath.clear();
+    sub.onProgress = nullptr;
+
+    AlnsResult result;
+    result.best = initial;
+    if (!result.best.unassigned.empty())
+        repairRegret(result.best, inst, 2);
+    result.trace.emplace_back(secondsSince(startTotal), result.best.totalCost);
+
+    ThreadPool pool(prm.threads);
+    std::mt19937 rng(deriveSeed(seed, 0));
+    long long rounds = (prm.maxIter + prm.decompositionIterations - 1) / prm.decompositionIterations;
+    for (long long round = 0; round < rounds; ++round)
+    {
+        if (cancelRequested(prm) || secondsSince(startTotal) > prm.maxTimeSeconds)
+            break;
+
+        const Solution &cur = result.best;
+        int used = (int)(cur.routes.size() - cur.freeRoutes.size());
+        std::vector<std::vector<int>> groups =
+            groupRoutesByAngle(cur, inst, prm.decompositionSize, (int)(rng() % std::max(used, 1)));
+
+        // A primeira rodada parte da solução inicial; as seguintes, de rotas já otimizadas
+        double tempFactor = round == 0 ? prm.startTempFactor : prm.warmStartTempFactor;
+        std::vector<AlnsResult> subResults(groups.size());
+        std::vector<std::vector<std::vector<int>>> subPaths(groups.size()); // Em ids globais
+        pool.parallelFor((int)groups.size(), [&](int g)
+                         {
+            Subproblem sp = buildSubproblem(cur, groups[g], inst);
+            AlnsState st = startState(sp.initial, tempFactor, deriveSeed(seed, ((uint64_t)(round + 1) << 32) + g));
+            subResults[g] = runAlns(sp.inst, sub, st, startTotal);
+            for (const Route &r : subResults[g].best.routes)
+            {
+                if (r.path.empty())
+                    continue;
+                subPaths[g].emplace_back();
+                for (int c : r.path)
+                    subPaths[g].back().push_back(sp.global[c]);
+            } });
+
+        std::vector<std::vector<int>> paths;
+        for (size_t g = 0; g < groups.size(); ++g)
+        {
+            result.iterations += subResults[g].iterations;
+            result.evaluations += subResults[g].evaluations;
+            result.duplicates += subResults[g].duplicates;
+            result.profile.merge(subResults[g].profile);
+            for (auto &path : subPaths[g])
+                paths.push_back(std::move(path));
+        }
+        Solution next = solutionFromRoutes(paths, {}, inst);
+        bool improved = next.totalCost < result.best.totalCost;
+        result.best = std::move(next);
+        if (improved)
+        {
+            result.trace.emplace_back(secondsSince(startTotal), result.best.totalCost);
+            if (prm.verbose)
+                std::cout << "Rodada " << round << " | " << groups.size() << " grupos | Novo Best: "
+                          << result.best.totalCost << std::endl;
+        }
+        if (prm.onProgress)
+            prm.onProgress(AlnsProgress{0, result.iterations, secondsSince(startTotal), result.best.totalCost,
+                                        result.best.totalCost, 0, improved});
+    }
+    if (prm.verbose && secondsSince(startTotal) > prm.maxTimeSeconds)
+        std::cout << "Tempo limite (" << prm.maxTimeSeconds << "s) atingido." << std::endl;
+    return result;
+}
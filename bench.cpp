@@ -0,0 +1,786 @@
+// Benchmarks do ALNS, com saída em JSON
+//
+//   g++ -O3 -std=c++17 -pthread bench.cpp -o alns_bench
+//
+//   ./alns_bench micro [--sizes 50,200,1000,5000] [--min-time s] [--out arquivo.json]
+//       Tempo médio por chamada de loadInstance, updateSolution, initialSolution,
+//       savingsSolution e de cada operador de destroy/repair em instâncias
+//       geradas (uniformes).
+//
+//   ./alns_bench suite <pasta> [--seeds 1,2,3] [--time s] [--iters n] [--target pct]
+//                      [--granular k] [--construct nn|cw] [--out arquivo.json]
+//       Roda o ALNS completo em cada .vrp da pasta, para cada seed, e reporta
+//       iterações/s, custo final, gap e tempo até o alvo (contado do início da
+//       construção da solução inicial). O BKS vem do arquivo <instancia>.sol
+//       ao lado (linha "Cost N", formato CVRPLIB), se existir.
+//
+//   ./alns_bench threads <arquivo.vrp> [--sweep islands|batch|repair] [--counts 1,2,4,8]
+//                        [--seeds 1,2,3] [--time s] [--iters n] [--granular k]
+//                        [--out arquivo.json]
+//       Varredura do número de ilhas (--threads), do tamanho do lote (--batch)
+//       ou das threads do reparo (--repair-threads): vazão (candidatos
+//       avaliados/s), custo médio e ganho sobre o primeiro valor.
+//
+//   ./alns_bench tune <pasta> [--configs n] [--budget runs] [--metric gap|ttt]
+//                     [--time s] [--iters n] [--target pct] [--first-test b]
+//                     [--seed s] [--workers n] [--granular k] [--out arquivo.json]
+//                     [--out-config arq.cfg]
+//       Corrida no estilo F-Race: configurações aleatórias de parâmetros (mais
+//       a padrão) são avaliadas bloco a bloco (instância, seed) em paralelo e
+//       as estatisticamente piores saem a cada bloco (Friedman + Conover,
+//       alfa = 0,05). Grava a melhor em --out-config (formato de --config).
+//
+//   ./alns_bench check
+//       Verificações rápidas da API de biblioteca (cancelamento de AlnsSolver e
+//       DynamicPlan); código de saída 1 se alguma falhar.
+
+#include "alns.h"
+
+#include <filesystem>
+
+// ==========================================
+// UTILITÁRIOS
+// ==========================================
+
+std::vector<int> parseIntList(const std::string &s)
+{
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            out.push_back(std::stoi(item));
+    return out;
+}
+
+// Instância uniforme em [0, 1000]^2 com depósito no centro e demandas 1..10;
+// capacidade para ~10 clientes por rota
+Instance generateInstance(int customers, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<> coord(0, 1000);
+    std::uniform_int_distribution<> demand(1, 10);
+
+    std::vector<Node> nodes(customers + 1);
+    nodes[0] = {0, 500, 500, 0};
+    for (int i = 1; i <= customers; ++i)
+    {
+        nodes[i].x = std::round(coord(rng));
+        nodes[i].y = std::round(coord(rng));
+        nodes[i].demand = demand(rng);
+    }
+    return makeInstance(std::move(nodes), 55);
+}
+
+void writeInstance(const Instance &inst, const std::string &path)
+{
+    std::ofstream out(path);
+    out << "NAME : bench\nTYPE : CVRP\nDIMENSION : " << inst.dimension << "\nEDGE_WEIGHT_TYPE : EUC_2D\n";
+    out << "CAPACITY : " << inst.capacity << "\nNODE_COORD_SECTION\n";
+    for (int i = 0; i < inst.dimension; ++i)
+        out << i + 1 << " " << inst.nodes[i].x << " " << inst.nodes[i].y << "\n";
+    out << "DEMAND_SECTION\n";
+    for (int i = 0; i < inst.dimension; ++i)
+        out << i + 1 << " " << inst.nodes[i].demand << "\n";
+    out << "DEPOT_SECTION\n1\n-1\nEOF\n";
+}
+
+// Custo da melhor solução conhecida (linha "Cost N" do .sol), ou -1
+long long readBks(const std::filesystem::path &vrp)
+{
+    std::filesystem::path sol = vrp;
+    sol.replace_extension(".sol");
+    std::ifstream in(sol);
+    std::string line;
+    while (std::getline(in, line))
+        if (line.rfind("Cost", 0) == 0)
+            return std::llround(std::stod(line.substr(4)));
+    return -1;
+}
+
+// Primeiro instante em que o melhor custo atingiu target (-1 se não atingiu)
+double timeToTarget(const std::vector<std::pair<double, long long>> &trace, long long target)
+{
+    for (const auto &pt : trace)
+        if (pt.second <= target)
+            return pt.first;
+    return -1;
+}
+
+// Tempo médio (µs) de op(); setup() prepara cada repetição fora da medição.
+// Repete até somar minTime segundos medidos (mínimo de 3 repetições).
+struct Timing
+{
+    int reps = 0;
+    double meanUs = 0;
+};
+
+template <class Setup, class Op>
+Timing measure(Setup setup, Op op, double minTime)
+{
+    Timing t;
+    double total = 0;
+    while (t.reps < 3 || total < minTime)
+    {
+        setup();
+        auto t0 = std::chrono::steady_clock::now();
+        op();
+        total += secondsSince(t0);
+        ++t.reps;
+    }
+    t.meanUs = total * 1e6 / t.reps;
+    return t;
+}
+
+// ==========================================
+// MICROBENCHMARKS
+// ==========================================
+
+void runMicro(const std::vector<int> &sizes, double minTime, std::ostream &json)
+{
+    const uint32_t seed = 12345;
+    const double removePct = 0.15;
+    bool first = true;
+    json << "{\n  \"benchmark\": \"micro\",\n  \"removePct\": " << removePct << ",\n  \"results\": [";
+
+    auto emit = [&](const char *op, int n, const Timing &t)
+    {
+        json << (first ? "\n" : ",\n") << "    {\"op\": \"" << op << "\", \"customers\": " << n
+             << ", \"reps\": " << t.reps << ", \"meanUs\": " << std::fixed << std::setprecision(2) << t.meanUs
+             << std::defaultfloat << "}";
+        first = false;
+        std::cerr << std::setw(16) << op << " n=" << std::setw(5) << n << " " << std::fixed << std::setprecision(1)
+                  << std::setw(12) << t.meanUs << " us (" << t.reps << " reps)" << std::defaultfloat << std::endl;
+    };
+
+    for (int n : sizes)
+    {
+        Instance inst = generateInstance(n, seed);
+
+        std::string path = "bench_tmp_" + std::to_string(n) + ".vrp";
+        writeInstance(inst, path);
+        emit("loadInstance", n, measure([] {}, [&] { loadInstance(path); }, minTime));
+        std::remove(path.c_str());
+
+        emit("initialSolution", n, measure([] {}, [&] { initialSolution(inst); }, minTime));
+        emit("savingsSolution", n, measure([] {}, [&] { savingsSolution(inst); }, minTime));
+
+        Solution base = initialSolution(inst);
+        Solution work;
+        emit("updateSolution", n, measure([&] { work = base; }, [&] { updateSolution(work, inst); }, minTime));
+
+        int q = std::max(1, (int)(n * removePct));
+        std::mt19937 rng(seed);
+        emit("destroyRandom", n, measure([&] { work = base; }, [&] { destroyRandom(work, q, inst, rng); }, minTime));
+        emit("destroyWorst", n, measure([&] { work = base; }, [&] { destroyWorst(work, q, inst, rng); }, minTime));
+        emit("destroyShaw", n, measure([&] { work = base; }, [&] { destroyShaw(work, q, inst, rng); }, minTime));
+
+        // Reparos partem sempre da mesma solução parcial
+        Solution partial = base;
+        std::mt19937 prng(seed);
+        destroyRandom(partial, q, inst, prng);
+        emit("repairGreedy", n, measure([&] { work = partial; }, [&] { repairGreedy(work, inst, rng); }, minTime));
+        emit("repairRegret2", n, measure([&] { work = partial; }, [&] { repairRegret(work, inst, 2); }, minTime));
+        emit("repairRegret3", n, measure([&] { work = partial; }, [&] { repairRegret(work, inst, 3); }, minTime));
+    }
+    json << "\n  ]\n}\n";
+}
+
+// ==========================================
+// SUÍTE PONTA A PONTA
+// ==========================================
+
+void runSuite(const std::string &dir, const std::vector<int> &seeds, const AlnsParams &prm, int granularK,
+              bool savingsStart, double targetPct, std::ostream &json)
+{
+    std::vector<std::filesystem::path> files;
+    for (const auto &e : std::filesystem::directory_iterator(dir))
+        if (e.path().extension() == ".vrp")
+            files.push_back(e.path());
+    std::sort(files.begin(), files.end());
+
+    json << "{\n  \"benchmark\": \"suite\",\n  \"timeLimit\": " << prm.maxTimeSeconds << ",\n  \"maxIter\": "
+         << prm.maxIter << ",\n  \"threads\": " << prm.threads << ",\n  \"granular\": " << granularK
+         << ",\n  \"construct\": \"" << (savingsStart ? "cw" : "nn") << "\",\n  \"targetGapPct\": " << targetPct
+         << ",\n  \"runs\": [";
+    // Como no alns_cvrp, o Clarke-Wright parte com a temperatura de uma solução já boa
+    AlnsParams run = prm;
+    if (savingsStart)
+        run.startTempFactor = run.warmStartTempFactor;
+    bool first = true;
+    for (const auto &file : files)
+    {
+        Instance inst = loadInstance(file.string());
+        buildNeighborLists(inst, granularK);
+        auto startInitial = std::chrono::steady_clock::now();
+        Solution initial = savingsStart ? savingsSolution(inst) : initialSolution(inst);
+        double constructSeconds = secondsSince(startInitial);
+        long long bks = readBks(file);
+        long long target = bks > 0 ? (long long)std::floor(bks * (1 + targetPct / 100.0)) : -1;
+
+        for (int seed : seeds)
+        {
+            auto start = std::chrono::steady_clock::now();
+            AlnsResult res = solve(inst, run, initial, seed, start);
+            double seconds = secondsSince(start);
+
+            double ttt = target >= 0 ? timeToTarget(res.trace, target) : -1;
+            if (ttt >= 0)
+                ttt += constructSeconds;
+
+            json << (first ? "\n" : ",\n") << "    {\"instance\": \"" << file.stem().string()
+                 << "\", \"customers\": " << inst.dimension - 1 << ", \"seed\": " << seed
+                 << ", \"iterations\": " << res.iterations << ", \"seconds\": " << std::fixed << std::setprecision(3)
+                 << seconds << ", \"itersPerSec\": " << std::setprecision(1) << res.iterations / seconds
+                 << ", \"initialCost\": " << initial.totalCost << ", \"constructSeconds\": " << std::setprecision(4)
+                 << constructSeconds << ", \"bestCost\": " << res.best.totalCost;
+            if (bks > 0)
+                json << ", \"bks\": " << bks << ", \"gapPct\": " << std::setprecision(3)
+                     << 100.0 * (res.best.totalCost - bks) / bks;
+            else
+                json << ", \"bks\": null, \"gapPct\": null";
+            if (ttt >= 0)
+                json << ", \"timeToTarget\": " << std::setprecision(3) << ttt;
+            else
+                json << ", \"timeToTarget\": null";
+            json << std::defaultfloat << "}";
+            first = false;
+
+            std::cerr << file.stem().string() << " seed " << seed << ": " << res.best.totalCost << " ("
+                      << res.iterations << " iter, " << std::fixed << std::setprecision(2) << seconds << "s)"
+                      << std::defaultfloat << std::endl;
+        }
+    }
+    json << "\n  ]\n}\n";
+}
+
+// ==========================================
+// VARREDURA DE THREADS
+// ==========================================
+
+// Roda o ALNS numa instância com cada valor de 'counts' no modo 'sweep' e
+// reporta candidatos avaliados por segundo, custo final e o ganho de vazão
+// sobre o primeiro valor. Modos: "islands" (--threads; com --iters, cada ilha
+// faz as suas iterações), "batch" (--batch k: k candidatos por iteração, num
+// pool de min(k, núcleos) threads) e "repair" (--repair-threads: só muda os
+// reparos por regret com PARALLEL_REPAIR_MIN clientes pendentes ou mais, então
+// pede instância grande). O mesmo orçamento (--time/--iters) vale para todos.
+// O número de núcleos vai no JSON: acima dele as threads só disputam a CPU.
+void runThreadSweep(const std::string &path, const std::string &sweep, const std::vector<int> &counts,
+                    const std::vector<int> &seeds, const AlnsParams &prm, int granularK, std::ostream &json)
+{
+    Instance inst = loadInstance(path);
+    buildNeighborLists(inst, granularK);
+    Solution initial = initialSolution(inst);
+    unsigned cores = std::thread::hardware_concurrency();
+
+    json << "{\n  \"benchmark\": \"threads\",\n  \"sweep\": \"" << sweep << "\",\n  \"instance\": \""
+         << std::filesystem::path(path).stem().string() << "\",\n  \"hardwareThreads\": " << cores
+         << ",\n  \"timeLimit\": " << prm.maxTimeSeconds << ",\n  \"maxIter\": " << prm.maxIter
+         << ",\n  \"granular\": " << granularK << ",\n  \"runs\": [";
+    double baseRate = 0;
+    bool first = true;
+    for (int n : counts)
+    {
+        n = std::max(1, n);
+        AlnsParams run = prm;
+        int threads = n;
+        if (sweep == "islands")
+            run.threads = n;
+        else if (sweep == "repair")
+            run.repairThreads = n;
+        else
+        {
+            run.batchSize = n;
+            threads = std::min<int>(n, std::max(1u, cores)); // Pool do lote em runAlns
+        }
+        long long evaluations = 0, costSum = 0;
+        double seconds = 0;
+        for (int seed : seeds)
+        {
+            auto start = std::chrono::steady_clock::now();
+            AlnsResult res = solve(inst, run, initial, seed, start);
+            seconds += secondsSince(start);
+            evaluations += res.evaluations;
+            costSum += res.best.totalCost;
+        }
+        double rate = evaluations / seconds;
+        if (first)
+            baseRate = rate;
+        double meanCost = (double)costSum / seeds.size();
+
+        json << (first ? "\n" : ",\n") << "    {\"count\": " << n << ", \"threads\": " << threads << ", \"seconds\": " << std::fixed
+             << std::setprecision(3) << seconds / seeds.size() << ", \"evaluationsPerSec\": " << std::setprecision(1)
+             << rate << ", \"speedup\": " << std::setprecision(2) << rate / baseRate << ", \"meanCost\": "
+             << std::setprecision(1) << meanCost << std::defaultfloat << "}";
+        first = false;
+
+        std::cerr << sweep << " " << std::setw(3) << n << " (" << threads << " thread(s)): " << std::fixed << std::setprecision(1) << std::setw(10)
+                  << rate << " aval/s (" << std::setprecision(2) << rate / baseRate << "x), custo medio "
+                  << std::setprecision(1) << meanCost << std::defaultfloat << std::endl;
+    }
+    json << "\n  ]\n}\n";
+}
+
+// ==========================================
+// AJUSTE DE PARÂMETROS (CORRIDA F-RACE)
+// ==========================================
+
+// Espaço de busca: faixa de cada parâmetro sorteado. LogComplement sorteia
+// 1 - valor em escala log (taxas de resfriamento próximas de 1).
+enum class TuneScale
+{
+    Linear,
+    Log,
+    LogComplement
+};
+
+struct TuneRange
+{
+    const char *name;
+    double lo, hi;
+    TuneScale scale;
+    bool integer;
+};
+
+const TuneRange TUNE_SPACE[] = {
+    {"startTempFactor", 0.0002, 0.1, TuneScale::Log, false},
+    {"coolingRate", 0.999, 0.99999, TuneScale::LogComplement, false},
+    {"minRemPct", 0.02, 0.25, TuneScale::Linear, false},
+    {"maxRemPct", 0.1, 0.6, TuneScale::Linear, false},
+    {"sigma1", 1, 50, TuneScale::Linear, false},
+    {"sigma2", 1, 50, TuneScale::Linear, false},
+    {"sigma3", 1, 50, TuneScale::Linear, false},
+    {"reactionFactor", 0.01, 0.5, TuneScale::Log, false},
+    {"segmentSize", 20, 500, TuneScale::Log, true},
+};
+
+AlnsParams sampleParams(const AlnsParams &base, std::mt19937 &rng)
+{
+    AlnsParams prm = base;
+    std::uniform_real_distribution<> u(0, 1);
+    for (const TuneRange &r : TUNE_SPACE)
+    {
+        double v;
+        if (r.scale == TuneScale::Linear)
+            v = r.lo + u(rng) * (r.hi - r.lo);
+        else if (r.scale == TuneScale::Log)
+            v = std::exp(std::log(r.lo) + u(rng) * (std::log(r.hi) - std::log(r.lo)));
+        else
+            v = 1 - std::exp(std::log(1 - r.hi) + u(rng) * (std::log(1 - r.lo) - std::log(1 - r.hi)));
+        std::ostringstream text;
+        if (r.integer)
+            text << std::lround(v);
+        else
+            text << std::setprecision(6) << v;
+        setParam(prm, r.name, text.str());
+    }
+    if (prm.minRemPct > prm.maxRemPct)
+        std::swap(prm.minRemPct, prm.maxRemPct);
+    return prm;
+}
+
+// (nome, valor) dos parâmetros ajustados, no formato de writeParams
+std::vector<std::pair<std::string, std::string>> tunedValues(const AlnsParams &prm)
+{
+    std::ostringstream text;
+    writeParams(prm, text);
+    std::vector<std::pair<std::string, std::string>> out;
+    std::istringstream lines(text.str());
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        size_t eq = line.find(" = ");
+        std::string name = line.substr(0, eq);
+        for (const TuneRange &r : TUNE_SPACE)
+            if (name == r.name)
+                out.emplace_back(name, line.substr(eq + 3));
+    }
+    return out;
+}
+
+// Postos dentro de um bloco (1 = melhor), empates com o posto médio
+std::vector<double> ranksOf(const std::vector<double> &v)
+{
+    std::vector<int> idx(v.size());
+    for (size_t i = 0; i < idx.size(); ++i)
+        idx[i] = i;
+    std::sort(idx.begin(), idx.end(), [&](int a, int b) { return v[a] < v[b]; });
+    std::vector<double> r(v.size());
+    for (size_t i = 0; i < idx.size();)
+    {
+        size_t j = i;
+        while (j + 1 < idx.size() && v[idx[j + 1]] == v[idx[i]])
+            ++j;
+        for (size_t k = i; k <= j; ++k)
+            r[idx[k]] = (i + j) / 2.0 + 1;
+        i = j + 1;
+    }
+    return r;
+}
+
+// Quantis para alfa = 0,05: qui-quadrado 0,95 (Wilson-Hilferty) e t de
+// Student 0,975 (expansão de Cornish-Fisher), suficientes para o teste
+double chiSquare95(int df)
+{
+    const double z = 1.6448536;
+    double a = 2.0 / (9.0 * df);
+    return df * std::pow(1 - a + z * std::sqrt(a), 3);
+}
+
+double studentT975(int df)
+{
+    const double z = 1.9599640;
+    double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+    double v = df;
+    return z + (z3 + z) / (4 * v) + (5 * z5 + 16 * z3 + 3 * z) / (96 * v * v) +
+           (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * v * v * v);
+}
+
+// Teste de Friedman sobre results[bloco][config] (menor = melhor) e, se ele
+// rejeita a igualdade, comparação de cada configuração com a de menor soma de
+// postos (Conover), como no F-Race. Devolve a soma de postos e quem sobrevive.
+std::vector<bool> friedmanRace(const std::vector<std::vector<double>> &results, std::vector<double> &rankSum)
+{
+    int b = (int)results.size(), m = (int)results[0].size();
+    rankSum.assign(m, 0);
+    double sumSq = 0;
+    for (const auto &block : results)
+    {
+        std::vector<double> r = ranksOf(block);
+        for (int j = 0; j < m; ++j)
+        {
+            rankSum[j] += r[j];
+            sumSq += r[j] * r[j];
+        }
+    }
+    std::vector<bool> alive(m, true);
+    double c = b * m * (m + 1.0) * (m + 1.0) / 4;
+    if (m < 2 || b < 2 || sumSq - c <= 0)
+        return alive;
+
+    double dev = 0;
+    for (int j = 0; j < m; ++j)
+        dev += (rankSum[j] - b * (m + 1) / 2.0) * (rankSum[j] - b * (m + 1) / 2.0);
+    double stat = (m - 1) * dev / (sumSq - c);
+    if (stat <= chiSquare95(m - 1))
+        return alive;
+
+    int best = (int)(std::min_element(rankSum.begin(), rankSum.end()) - rankSum.begin());
+    double spread = 2 * b * (1 - stat / (b * (m - 1.0))) * (sumSq - c) / ((b - 1.0) * (m - 1.0));
+    double critical = studentT975((b - 1) * (m - 1)) * std::sqrt(std::max(0.0, spread));
+    for (int j = 0; j < m; ++j)
+        alive[j] = rankSum[j] - rankSum[best] <= critical;
+    return alive;
+}
+
+struct TuneOptions
+{
+    int configs = 32;
+    int budget = 400;    // Total de execuções do ALNS
+    int firstTest = 5;   // Blocos antes do primeiro teste
+    bool ttt = false;    // Métrica: tempo até o alvo (senão, gap do custo final)
+    double targetPct = 1.0;
+    uint64_t seed = 1;
+    int workers = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::string configOut;
+};
+
+void runTune(const std::string &dir, const AlnsParams &base, int granularK, const TuneOptions &opt,
+             std::ostream &json)
+{
+    struct TrainingInstance
+    {
+        std::string name;
+        Instance inst;
+        Solution initial;
+        long long bks;
+    };
+    std::vector<std::filesystem::path> files;
+    for (const auto &e : std::filesystem::directory_iterator(dir))
+        if (e.path().extension() == ".vrp")
+            files.push_back(e.path());
+    std::sort(files.begin(), files.end());
+    if (files.empty())
+    {
+        std::cerr << "Nenhum .vrp em " << dir << std::endl;
+        return;
+    }
+    std::vector<TrainingInstance> train;
+    for (const auto &file : files)
+    {
+        TrainingInstance t{file.stem().string(), loadInstance(file.string()), {}, readBks(file)};
+        buildNeighborLists(t.inst, granularK);
+        t.initial = initialSolution(t.inst);
+        train.push_back(std::move(t));
+    }
+
+    // Candidatas: a configuração de partida e (configs - 1) sorteadas
+    std::mt19937 rng(deriveSeed(opt.seed, 0));
+    std::vector<AlnsParams> cands = {base};
+    while ((int)cands.size() < opt.configs)
+        cands.push_back(sampleParams(base, rng));
+    for (auto &c : cands)
+    {
+        c.threads = 1;
+        c.verbose = false;
+    }
+
+    std::vector<int> alive(cands.size());
+    for (size_t i = 0; i < alive.size(); ++i)
+        alive[i] = i;
+    std::vector<std::vector<double>> metric; // [bloco][candidata]; NaN = eliminada antes
+    std::vector<double> rankSum;
+    ThreadPool pool(opt.workers);
+    int runs = 0;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    for (int block = 0; alive.size() > 1 && runs + (int)alive.size() <= opt.budget; ++block)
+    {
+        TrainingInstance &t = train[block % train.size()];
+        uint32_t seed = deriveSeed(opt.seed, block + 1);
+        std::vector<long long> cost(alive.size());
+        std::vector<std::vector<std::pair<double, long long>>> traces(alive.size());
+        pool.parallelFor((int)alive.size(), [&](int k)
+                         {
+            AlnsResult res = solve(t.inst, cands[alive[k]], t.initial, seed, std::chrono::steady_clock::now());
+            cost[k] = res.best.totalCost;
+            traces[k] = std::move(res.trace); });
+        runs += (int)alive.size();
+
+        // Gap (%) sobre o BKS, ou sobre o melhor do bloco sem BKS; ou tempo até o
+        // alvo (referência + pct), com o dobro do orçamento para quem não chega (PAR-2)
+        std::vector<double> row(cands.size(), nan);
+        long long ref = t.bks > 0 ? t.bks : *std::min_element(cost.begin(), cost.end());
+        long long target = (long long)std::floor(ref * (1 + opt.targetPct / 100.0));
+        for (size_t k = 0; k < alive.size(); ++k)
+        {
+            double ttt = timeToTarget(traces[k], target);
+            if (!opt.ttt)
+                row[alive[k]] = 100.0 * (cost[k] - ref) / ref;
+            else
+                row[alive[k]] = ttt >= 0 ? ttt : 2 * base.maxTimeSeconds;
+        }
+        metric.push_back(row);
+
+        std::vector<int> next = alive;
+        if (block + 1 >= opt.firstTest)
+        {
+            std::vector<std::vector<double>> sub(metric.size());
+            for (size_t bl = 0; bl < metric.size(); ++bl)
+                for (int c : alive)
+                    sub[bl].push_back(metric[bl][c]);
+            std::vector<bool> keep = friedmanRace(sub, rankSum);
+            next.clear();
+            for (size_t k = 0; k < alive.size(); ++k)
+                if (keep[k])
+                    next.push_back(alive[k]);
+        }
+        std::cerr << "bloco " << block + 1 << " (" << t.name << ", seed " << seed << "): " << alive.size() << " -> "
+                  << next.size() << " configuracoes, " << runs << " execucoes" << std::endl;
+        alive = std::move(next);
+    }
+
+    // Postos finais sobre todos os blocos entre as sobreviventes
+    std::vector<std::vector<double>> sub(metric.size());
+    for (size_t bl = 0; bl < metric.size(); ++bl)
+        for (int c : alive)
+            sub[bl].push_back(metric[bl][c]);
+    if (!sub.empty())
+        friedmanRace(sub, rankSum);
+    else
+        rankSum.assign(alive.size(), 0);
+    std::vector<int> order(alive.size());
+    for (size_t k = 0; k < order.size(); ++k)
+        order[k] = k;
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return rankSum[a] < rankSum[b]; });
+
+    json << "{\n  \"benchmark\": \"tune\",\n  \"metric\": \"" << (opt.ttt ? "ttt" : "gap") << "\",\n  \"timeLimit\": "
+         << base.maxTimeSeconds << ",\n  \"maxIter\": " << base.maxIter << ",\n  \"instances\": " << train.size()
+         << ",\n  \"configs\": " << cands.size() << ",\n  \"blocks\": " << metric.size() << ",\n  \"runs\": " << runs
+         << ",\n  \"survivors\": [";
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        int c = alive[order[i]];
+        double mean = 0;
+        for (const auto &row : metric)
+            mean += row[c];
+        std::string fields;
+        for (const auto &kv : tunedValues(cands[c]))
+            fields += (fields.empty() ? "\"" : ", \"") + kv.first + "\": " + kv.second;
+        json << (i ? ",\n" : "\n") << "    {\"config\": " << c << ", \"default\": " << (c == 0 ? "true" : "false")
+             << ", \"meanRank\": " << std::fixed << std::setprecision(2)
+             << (metric.empty() ? 0 : rankSum[order[i]] / metric.size()) << ", \"meanMetric\": "
+             << std::setprecision(3) << (metric.empty() ? 0 : mean / metric.size()) << std::defaultfloat
+             << ", \"params\": {" << fields << "}}";
+    }
+    json << "\n  ]\n}\n";
+
+    const AlnsParams &best = cands[alive[order[0]]];
+    std::cerr << "Melhor configuracao: " << alive[order[0]] << (alive[order[0]] == 0 ? " (a padrao)" : "")
+              << std::endl;
+    if (!opt.configOut.empty())
+    {
+        std::ofstream out(opt.configOut);
+        out << "# alns_bench tune: " << train.size() << " instancias, " << metric.size() << " blocos, " << runs
+            << " execucoes\n";
+        for (const auto &kv : tunedValues(best))
+            out << kv.first << " = " << kv.second << "\n";
+    }
+}
+
+// ==========================================
+// VERIFICAÇÕES DA API
+// ==========================================
+
+// O cancelamento é disparado do callback de progresso, na própria thread da
+// busca, para o resultado não depender do escalonamento
+int runCheck()
+{
+    Instance inst = generateInstance(100, 12345);
+    int failures = 0;
+    auto expect = [&](bool ok, const char *what)
+    {
+        std::cerr << (ok ? "ok     " : "FALHOU ") << what << std::endl;
+        failures += !ok;
+    };
+
+    AlnsSolver solver;
+    solver.params().maxIter = 300;
+    solver.params().maxTimeSeconds = 60;
+    expect(solver.solve(inst, 1).iterations == 300, "solve sem cancelamento faz todas as iteracoes");
+
+    solver.params().progressInterval = 50;
+    solver.params().onProgress = [&](const AlnsProgress &p)
+    {
+        if (!p.newBest && p.iteration == 100)
+            solver.cancel();
+    };
+    expect(solver.solve(inst, 1).iterations == 100, "cancel() durante o solve o encerra");
+
+    solver.params().onProgress = nullptr;
+    solver.cancel();
+    expect(solver.solve(inst, 1).iterations == 300, "cancel() sem solve em andamento nao afeta o proximo");
+
+    AlnsParams prm;
+    prm.verbose = false;
+    prm.maxIter = 300;
+    DynamicPlan plan(inst, initialSolution(inst), prm, 1);
+    long long before = plan.state().iteration;
+    plan.cancel();
+    plan.reoptimize(60);
+    expect(plan.state().iteration - before == 300, "DynamicPlan::cancel() entre rajadas nao afeta a proxima");
+
+    return failures ? 1 : 0;
+}
+
+// ==========================================
+// MAIN
+// ==========================================
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || (std::string(argv[1]) != "micro" && std::string(argv[1]) != "check" && argc < 3))
+    {
+        std::cout << "Uso: ./alns_bench micro [--sizes 50,200,1000,5000] [--min-time s] [--out arquivo.json]\n"
+                  << "     ./alns_bench suite <pasta> [--seeds 1,2,3] [--time s] [--iters n] [--target pct]\n"
+                  << "                        [--threads n] [--granular k] [--construct nn|cw] [--out arquivo.json]\n"
+                  << "     ./alns_bench threads <arquivo.vrp> [--sweep islands|batch|repair] [--counts 1,2,4,8]\n"
+                  << "                          [--seeds 1,2,3] [--time s] [--iters n] [--granular k] [--out arquivo.json]\n"
+                  << "     ./alns_bench tune <pasta> [--configs n] [--budget runs] [--metric gap|ttt] [--time s]\n"
+                  << "                        [--iters n] [--target pct] [--first-test b] [--seed s] [--workers n]\n"
+                  << "                        [--granular k] [--out arquivo.json] [--out-config arq.cfg]\n"
+                  << "     ./alns_bench check" << std::endl;
+        return 1;
+    }
+
+    std::string mode = argv[1];
+    if (mode == "check")
+        return runCheck();
+    std::vector<int> sizes = {50, 200, 1000, 5000};
+    std::vector<int> seeds = {1, 2, 3};
+    std::vector<int> counts = {1, 2, 4, 8};
+    std::string sweep = "islands";
+    double minTime = 0.5, targetPct = 1.0;
+    int granularK = 30;
+    bool savingsStart = false;
+    std::string outPath;
+    AlnsParams prm;
+    prm.verbose = false;
+    prm.maxTimeSeconds = 10;
+    TuneOptions tune;
+
+    for (int a = (mode == "micro") ? 2 : 3; a < argc; ++a)
+    {
+        std::string arg = argv[a];
+        if (a + 1 >= argc)
+            break;
+        if (arg == "--sizes")
+            sizes = parseIntList(argv[++a]);
+        else if (arg == "--min-time")
+            minTime = std::stod(argv[++a]);
+        else if (arg == "--sweep")
+            sweep = argv[++a];
+        else if (arg == "--counts")
+            counts = parseIntList(argv[++a]);
+        else if (arg == "--seeds")
+            seeds = parseIntList(argv[++a]);
+        else if (arg == "--time")
+            prm.maxTimeSeconds = std::stod(argv[++a]);
+        else if (arg == "--iters")
+            prm.maxIter = std::stoi(argv[++a]);
+        else if (arg == "--target")
+            targetPct = std::stod(argv[++a]);
+        else if (arg == "--threads")
+            prm.threads = std::max(1, std::stoi(argv[++a]));
+        else if (arg == "--granular")
+            granularK = std::stoi(argv[++a]);
+        else if (arg == "--construct")
+            savingsStart = std::string(argv[++a]) == "cw";
+        else if (arg == "--out")
+            outPath = argv[++a];
+        else if (arg == "--configs")
+            tune.configs = std::max(2, std::stoi(argv[++a]));
+        else if (arg == "--budget")
+            tune.budget = std::stoi(argv[++a]);
+        else if (arg == "--metric")
+            tune.ttt = std::string(argv[++a]) == "ttt";
+        else if (arg == "--first-test")
+            tune.firstTest = std::max(2, std::stoi(argv[++a]));
+        else if (arg == "--seed")
+            tune.seed = std::stoull(argv[++a]);
+        else if (arg == "--workers")
+            tune.workers = std::max(1, std::stoi(argv[++a]));
+        else if (arg == "--out-config")
+            tune.configOut = argv[++a];
+    }
+    tune.targetPct = targetPct;
+
+    // JSON em stdout (ou --out); progresso legível em stderr
+    std::ofstream file;
+    if (!outPath.empty())
+        file.open(outPath);
+    std::ostream &json = outPath.empty() ? std::cout : file;
+
+    if (mode == "micro")
+        runMicro(sizes, minTime, json);
+    else if (mode == "suite")
+        runSuite(argv[2], seeds, prm, granularK, savingsStart, targetPct, json);
+    else if (mode == "threads")
+    {
+        if (sweep != "islands" && sweep != "batch" && sweep != "repair")
+        {
+            std::cerr << "--sweep deve ser islands, batch ou repair: " << sweep << std::endl;
+            return 1;
+        }
+        runThreadSweep(argv[2], sweep, counts, seeds, prm, granularK, json);
+    }
+    else if (mode == "tune")
+        runTune(argv[2], prm, granularK, tune, json);
+    else
+    {
+        std::cerr << "Modo desconhecido: " << mode << std::endl;
+        return 1;
+    }
+    return 0;
+}
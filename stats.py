@@ -3,6 +3,7 @@ import os
 import re
 import math
 import statistics
+import json
 
 # ==============================================================================
 # CONFIGURAÇÕES DO EXPERIMENTO 
@@ -26,28 +27,23 @@ Z_SCORE = 1.96
 
 # ==============================================================================
 
-def rodar_algoritmo(idx):
-    """Executa o código C++ uma vez e retorna (Custo, Tempo)."""
-    try:
-        resultado = subprocess.run(
-            [EXECUTAVEL, ARQUIVO_INSTANCIA], 
-            capture_output=True, 
-            text=True
-        )
-        saida = resultado.stdout
-        
-        # Extrai Custo
-        match_custo = re.search(r"Melhor Custo.*:\s*(\d+)", saida)
-        custo = int(match_custo.group(1)) if match_custo else None
-        
-        # Extrai Tempo (para calcular MT - Mean Time)
-        match_tempo = re.search(r"Tempo.*:\s*([\d\.]+)", saida)
-        tempo = float(match_tempo.group(1)) if match_tempo else None
-        
-        return custo, tempo
-    except Exception as e:
-        print(f"Erro na execução {idx}: {e}")
-        return None, None
+def rodar_execucoes():
+    """Executa as NUM_EXECUCOES buscas em um único processo (--runs), em paralelo,
+    e retorna a lista de (Custo, Tempo) de cada execução."""
+    arquivo_json = "execucoes.json"
+    resultado = subprocess.run(
+        [EXECUTAVEL, ARQUIVO_INSTANCIA, "--runs", str(NUM_EXECUCOES),
+         "--bks", str(BKS_LITERATURA), "--json", arquivo_json],
+        capture_output=True,
+        text=True
+    )
+    if resultado.returncode != 0 or not os.path.exists(arquivo_json):
+        print(f"Erro na execução: {resultado.stderr}")
+        return []
+    with open(arquivo_json) as f:
+        dados = json.load(f)
+    os.remove(arquivo_json)
+    return [(r["cost"], r["seconds"]) for r in dados["results"]]
 
 def main():
     if not os.path.exists(ARQUIVO_INSTANCIA):
@@ -57,7 +53,7 @@ def main():
     # Compilação rápida para garantir (opcional)
     if not os.path.exists(EXECUTAVEL):
         print("Compilando...")
-        subprocess.run(["g++", "-O3", "-std=c++17", "main.cpp", "-o", "alns_cvrp"])
+        subprocess.run(["g++", "-O3", "-std=c++17", "-pthread", "main.cpp", "-o", "alns_cvrp"])
 
     print(f"--- INICIANDO VALIDAÇÃO ESTATÍSTICA ---")
     print(f"Instância: {ARQUIVO_INSTANCIA}")
@@ -68,14 +64,11 @@ def main():
     custos = []
     tempos = []
 
-    for i in range(NUM_EXECUCOES):
-        c, t = rodar_algoritmo(i)
-        if c is not None:
-            custos.append(c)
-            tempos.append(t)
-            # Feedback visual simples (progresso)
-            gap_inst = ((c - BKS_LITERATURA) / BKS_LITERATURA) * 100
-            print(f"Teste {i+1}/{NUM_EXECUCOES} | Custo: {c} | Gap: {gap_inst:.2f}% | Tempo: {t:.4f}s")
+    for i, (c, t) in enumerate(rodar_execucoes()):
+        custos.append(c)
+        tempos.append(t)
+        gap_inst = ((c - BKS_LITERATURA) / BKS_LITERATURA) * 100
+        print(f"Teste {i+1}/{NUM_EXECUCOES} | Custo: {c} | Gap: {gap_inst:.2f}% | Tempo: {t:.4f}s")
 
     if not custos:
         print("Nenhum resultado coletado.")